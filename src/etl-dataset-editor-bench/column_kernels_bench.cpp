@@ -0,0 +1,172 @@
+/*
+ column_kernels_bench.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "column_kernels.h"
+#include "dataset.h"
+#include "statistics.h"
+
+using namespace std;
+using namespace etl76;
+
+/*
+ * Totals as summed before column kernels: one pass over instances w/ getters.
+ */
+static Statistics::Totals totalsByInstances(
+        const vector<DatasetInstance*>& instances,
+        const vector<ActivityClass>& activityClasses)
+{
+    Statistics::Totals t{};
+    double weightSum = 0;
+    for(const DatasetInstance* i:instances) {
+        const uint64_t meters = i->getTotalDistanceMeters() ? i->getTotalDistanceMeters() : i->getDistanceMeters();
+        t.instances++;
+        t.universalMeters += meters;
+        t.universalSeconds += i->getTotalTimeSeconds() ? i->getTotalTimeSeconds() : i->getTimeSeconds();
+        const unsigned code = i->getActivity().getCode();
+        const ActivityClass activity = code < activityClasses.size() ? activityClasses[code] : ActivityClass::OTHER;
+        switch(activity) {
+        case ActivityClass::CYCLING:
+            t.cyclingMeters += meters;
+            break;
+        case ActivityClass::C2:
+            t.c2Meters += meters;
+            break;
+        case ActivityClass::RUNNING:
+            t.runningMeters += meters;
+            break;
+        case ActivityClass::SAUNA:
+            t.saunaRounds += i->getRepetitions() ? i->getRepetitions() : 1;
+            break;
+        case ActivityClass::MEDITATION:
+            t.meditations++;
+            break;
+        case ActivityClass::OTHER:
+            break;
+        }
+        if(activity != ActivityClass::SAUNA) {
+            t.repetitions += static_cast<uint64_t>(i->getSquats()) + i->getPushUps() + i->getCrunches()
+                + i->getTurles() + i->getCalfs() + i->getRepetitions();
+        }
+        const float weight = i->getWeight();
+        if(weight > 0) {
+            t.minWeight = t.weighings ? min(t.minWeight, weight) : weight;
+            t.maxWeight = t.weighings ? max(t.maxWeight, weight) : weight;
+            weightSum += weight;
+            t.weighings++;
+        }
+    }
+    t.avgWeight = t.weighings ? weightSum/t.weighings : 0;
+    return t;
+}
+
+static bool sameTotals(const Statistics::Totals& a, const Statistics::Totals& b)
+{
+    // weight is summed in different order
+    return a.instances == b.instances
+        && a.universalMeters == b.universalMeters
+        && a.universalSeconds == b.universalSeconds
+        && a.cyclingMeters == b.cyclingMeters
+        && a.c2Meters == b.c2Meters
+        && a.runningMeters == b.runningMeters
+        && a.repetitions == b.repetitions
+        && a.weighings == b.weighings
+        && fabs(a.avgWeight-b.avgWeight) <= 1e-9*fabs(a.avgWeight)
+        && a.minWeight == b.minWeight
+        && a.maxWeight == b.maxWeight
+        && a.saunaRounds == b.saunaRounds
+        && a.meditations == b.meditations;
+}
+
+/*
+ * Best of the iterations in milliseconds.
+ */
+static double measure(unsigned iterations, const function<Statistics::Totals()>& totals, Statistics::Totals& result)
+{
+    double best = HUGE_VAL;
+    for(unsigned i=0; i<iterations; i++) {
+        auto start = chrono::steady_clock::now();
+        result = totals();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    return best;
+}
+
+/**
+ * @brief Benchmark of statistics totals (column kernels or scalar row pass) vs. loop over instances.
+ */
+int main(int argc, char* argv[])
+{
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s <dataset CSV> [iterations]\n", argv[0]);
+        return 1;
+    }
+    const unsigned iterations = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : 20;
+
+    Dataset dataset{};
+    Statistics statistics{};
+    try {
+        dataset.from_csv(argv[1]);
+        statistics.calculate(dataset.getColumns());
+    } catch(exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    const DatasetColumns& columns = dataset.getColumns();
+    const CategoricalFeature& activities = columns.getFeature(DatasetColumns::ACTIVITY);
+    vector<ActivityClass> activityClasses{};
+    for(unsigned code=0; code<activities.size(); code++) {
+        activityClasses.push_back(Statistics::classifyActivity(activities.getUtf8Value(code)));
+    }
+    printf("%s: %zu rows, best of %u iterations\n", argv[1], columns.size(), iterations);
+
+    Statistics::Totals expected;
+    const double loopMs = measure(iterations, [&] { return totalsByInstances(dataset.getInstances(), activityClasses); }, expected);
+    printf("%-24s %9.3f ms\n", "DatasetInstance* loop", loopMs);
+
+    static const pair<ColumnKernels::InstructionSet, const char*> INSTRUCTION_SETS[] = {
+        {ColumnKernels::InstructionSet::SCALAR, "scalar (row pass)"},
+        {ColumnKernels::InstructionSet::SSE41, "kernels SSE4.1"},
+        {ColumnKernels::InstructionSet::AVX2, "kernels AVX2"}
+    };
+    const ColumnKernels::InstructionSet supported = ColumnKernels::getSupportedInstructionSet();
+    bool same = true;
+    for(const auto& instructionSet:INSTRUCTION_SETS) {
+        if(instructionSet.first > supported) {
+            break;
+        }
+        ColumnKernels::useInstructionSet(instructionSet.first);
+        Statistics::Totals totals;
+        const double kernelsMs = measure(iterations, [&] { return statistics.getTotals(columns); }, totals);
+        const bool sameAsLoop = sameTotals(totals, expected);
+        same = same && sameAsLoop;
+        printf("%-24s %9.3f ms %6.2fx%s\n",
+               instructionSet.second,
+               kernelsMs,
+               loopMs/kernelsMs,
+               sameAsLoop ? "" : "  DIFFERENT TOTALS");
+    }
+    ColumnKernels::useInstructionSet(supported);
+
+    return same ? 0 : 2;
+}
@@ -0,0 +1,51 @@
+# etl-dataset-editor-bench.pro     Endurance Training Log dataset editor
+#
+# Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+# Benchmark of column kernels (statistics totals) vs. loop over instances:
+#
+#   qmake && make && ./etl-dataset-editor-bench <dataset CSV> [iterations]
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -std=c++17 -pthread
+LIBS += -pthread
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+EDITOR_DIR = ../etl-dataset-editor
+INCLUDEPATH += $$EDITOR_DIR
+
+SOURCES += \
+    column_kernels_bench.cpp \
+    $$EDITOR_DIR/categorical_feature.cpp \
+    $$EDITOR_DIR/column_kernels.cpp \
+    $$EDITOR_DIR/dataset.cpp \
+    $$EDITOR_DIR/dataset_columns.cpp \
+    $$EDITOR_DIR/dataset_csv_reader.cpp \
+    $$EDITOR_DIR/dataset_csv_writer.cpp \
+    $$EDITOR_DIR/dataset_instance.cpp \
+    $$EDITOR_DIR/dataset_instance_pool.cpp \
+    $$EDITOR_DIR/dataset_journal.cpp \
+    $$EDITOR_DIR/dataset_saver.cpp \
+    $$EDITOR_DIR/dataset_snapshot.cpp \
+    $$EDITOR_DIR/date_index.cpp \
+    $$EDITOR_DIR/mapped_file.cpp \
+    $$EDITOR_DIR/statistics.cpp \
+    $$EDITOR_DIR/utf8_column.cpp
@@ -0,0 +1,449 @@
+/*
+ analytics_cache.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "analytics_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+
+#include "dataset.h"
+#include "dataset_snapshot.h"
+#include "mapped_file.h"
+
+namespace etl76 {
+
+using namespace std;
+
+static const char CACHE_MAGIC[4] = {'E', 'T', 'L', 'A'};
+static const uint32_t CACHE_BYTE_ORDER_MARK = 0x01020304;
+
+string AnalyticsCache::cachePath(const string& csvFilePath)
+{
+    return DatasetSnapshot::siblingPath(csvFilePath, FILE_EXTENSION);
+}
+
+/*
+ * Hash
+ */
+
+class ContentHash
+{
+private:
+    static const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+    uint64_t hash;
+
+    void mix(uint64_t word) {
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 29;
+    }
+
+public:
+    ContentHash() : hash(0xCBF29CE484222325ull) {}
+
+    /*
+     * Bytes are mixed by 8 byte words - the size is mixed as well so that
+     * concatenations of different items differ.
+     */
+    void update(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        size_t i = 0;
+        for(; i+sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, bytes+i, sizeof(word));
+            mix(word);
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, bytes+i, size-i);
+        mix(tail);
+        mix(size);
+    }
+    template<class T> void update(const vector<T>& items) {
+        update(items.data(), items.size()*sizeof(T));
+    }
+    void update(const QString& value) {
+        update(value.utf16(), static_cast<size_t>(value.size())*sizeof(ushort));
+    }
+    void update(string_view value) {
+        update(value.data(), value.size());
+    }
+
+    uint64_t get() const { return hash; }
+};
+
+uint64_t AnalyticsCache::contentHash(const DatasetColumns& columns)
+{
+    ContentHash hash{};
+    for(int c=0; c<DatasetColumns::UINT_COLUMN_COUNT; c++) {
+        hash.update(columns.getColumn(static_cast<DatasetColumns::UIntColumn>(c)));
+    }
+    for(int c=0; c<DatasetColumns::FLOAT_COLUMN_COUNT; c++) {
+        hash.update(columns.getColumn(static_cast<DatasetColumns::FloatColumn>(c)));
+    }
+    for(int c=0; c<DatasetColumns::CATEGORICAL_COLUMN_COUNT; c++) {
+        const DatasetColumns::CategoricalColumn column = static_cast<DatasetColumns::CategoricalColumn>(c);
+        for(const QString& value:columns.getFeature(column).getValues()) {
+            hash.update(value);
+        }
+        hash.update(columns.getColumn(column));
+    }
+    for(int c=0; c<DatasetColumns::STRING_COLUMN_COUNT; c++) {
+        // UTF-8 as kept by the column: values are not decoded to be hashed
+        const Utf8Column& column = columns.getColumn(static_cast<DatasetColumns::StringColumn>(c));
+        for(size_t row=0; row<column.size(); row++) {
+            hash.update(column.getUtf8(row));
+        }
+    }
+    return hash.get();
+}
+
+/*
+ * Writer
+ */
+
+class CacheWriter
+{
+private:
+    const string& filePath;
+    ofstream out;
+
+public:
+    explicit CacheWriter(const string& filePath)
+        : filePath(filePath),
+          out(filePath, ios::out|ios::binary|ios::trunc)
+    {
+        if(!out) {
+            throw EtlRuntimeException("Unable to create analytics cache file "+filePath);
+        }
+    }
+
+    void write(const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+    }
+    template<class T> void write(const T& value) {
+        static_assert(is_trivially_copyable<T>::value, "only trivially copyable values are written");
+        write(&value, sizeof(T));
+    }
+    template<class T> void write(const vector<T>& items) {
+        static_assert(is_trivially_copyable<T>::value, "only trivially copyable items are written");
+        write(static_cast<uint64_t>(items.size()));
+        write(items.data(), items.size()*sizeof(T));
+    }
+    void write(const string& value) {
+        write(static_cast<uint64_t>(value.size()));
+        write(value.data(), value.size());
+    }
+
+    void close() {
+        out.close();
+        if(!out) {
+            throw EtlRuntimeException("Unable to write analytics cache file "+filePath);
+        }
+    }
+};
+
+/*
+ * Reader
+ */
+
+class CacheReader
+{
+private:
+    const string& filePath;
+    const char* cursor;
+    const char* end;
+
+public:
+    CacheReader(const string& filePath, const char* begin, const char* end)
+        : filePath(filePath),
+          cursor(begin),
+          end(end)
+    {}
+
+    [[noreturn]] void damaged() const {
+        throw EtlRuntimeException("Analytics cache file "+filePath+" is damaged");
+    }
+
+    void read(void* data, size_t size) {
+        if(size > static_cast<size_t>(end-cursor)) {
+            damaged();
+        }
+        memcpy(data, cursor, size);
+        cursor += size;
+    }
+    template<class T> void read(T& value) {
+        static_assert(is_trivially_copyable<T>::value, "only trivially copyable values are read");
+        read(&value, sizeof(T));
+    }
+    uint64_t readCount(size_t itemSize) {
+        uint64_t count;
+        read(count);
+        if(count > static_cast<size_t>(end-cursor)/max<size_t>(itemSize, 1)) {
+            damaged();
+        }
+        return count;
+    }
+    template<class T> void read(vector<T>& items) {
+        static_assert(is_trivially_copyable<T>::value, "only trivially copyable items are read");
+        items.resize(readCount(sizeof(T)));
+        read(items.data(), items.size()*sizeof(T));
+    }
+    void read(string& value) {
+        value.resize(readCount(1));
+        read(&value[0], value.size());
+    }
+
+    bool atEnd() const { return cursor == end; }
+};
+
+/*
+ * Analytics
+ */
+
+static void writeAggregates(CacheWriter& out, const Statistics::Aggregates& aggregates)
+{
+    out.write(static_cast<uint64_t>(aggregates.size()));
+    for(const auto& keyAndAggregate:aggregates) {
+        const Statistics::Aggregate& a = keyAndAggregate.second;
+        out.write(keyAndAggregate.first);
+        out.write(a.year);
+        out.write(a.period);
+        out.write(a.instances);
+        out.write(a.universalMeters);
+        out.write(a.universalSeconds);
+        out.write(a.cyclingMeters);
+        out.write(a.c2Meters);
+        out.write(a.runningMeters);
+        out.write(a.repetitions);
+        out.write(a.weighings);
+        out.write(a.weightSum);
+        out.write(a.minWeight);
+        out.write(a.maxWeight);
+        out.write(a.firstWeightDay);
+        out.write(a.firstWeight);
+        out.write(a.lastWeightDay);
+        out.write(a.lastWeight);
+        out.write(a.saunaRounds);
+        out.write(a.meditations);
+    }
+}
+
+static void readAggregates(CacheReader& in, Statistics::Aggregates& aggregates)
+{
+    aggregates.clear();
+    for(uint64_t count = in.readCount(sizeof(Statistics::Aggregate)); count; count--) {
+        int64_t key;
+        Statistics::Aggregate a{};
+        in.read(key);
+        in.read(a.year);
+        in.read(a.period);
+        in.read(a.instances);
+        in.read(a.universalMeters);
+        in.read(a.universalSeconds);
+        in.read(a.cyclingMeters);
+        in.read(a.c2Meters);
+        in.read(a.runningMeters);
+        in.read(a.repetitions);
+        in.read(a.weighings);
+        in.read(a.weightSum);
+        in.read(a.minWeight);
+        in.read(a.maxWeight);
+        in.read(a.firstWeightDay);
+        in.read(a.firstWeight);
+        in.read(a.lastWeightDay);
+        in.read(a.lastWeight);
+        in.read(a.saunaRounds);
+        in.read(a.meditations);
+        aggregates.emplace_hint(aggregates.end(), key, std::move(a));
+    }
+}
+
+template<class K, class V>
+static void writeMap(CacheWriter& out, const map<K, V>& items)
+{
+    out.write(static_cast<uint64_t>(items.size()));
+    for(const auto& keyAndValue:items) {
+        out.write(keyAndValue.first);
+        out.write(keyAndValue.second);
+    }
+}
+
+template<class K, class V>
+static void readMap(CacheReader& in, map<K, V>& items)
+{
+    items.clear();
+    for(uint64_t count = in.readCount(sizeof(K)+sizeof(V)); count; count--) {
+        K key;
+        V value;
+        in.read(key);
+        in.read(value);
+        items.emplace_hint(items.end(), key, value);
+    }
+}
+
+void AnalyticsCache::write(
+        const string& csvFilePath,
+        uint64_t contentHash,
+        size_t rows,
+        const Statistics& statistics,
+        const TrainingLoad& trainingLoad,
+        const GearLedger& gearLedger,
+        const PersonalRecords& personalRecords)
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.engineVersion = ENGINE_VERSION;
+    header.byteOrderMark = CACHE_BYTE_ORDER_MARK;
+    header.contentHash = contentHash;
+    header.rows = rows;
+
+    // cache is written aside and renamed: a reader never sees half of it
+    string filePath{cachePath(csvFilePath)};
+    string tmpFilePath{filePath+".tmp"};
+    {
+        CacheWriter out{tmpFilePath};
+        out.write(header);
+
+        for(const Statistics::Aggregates& aggregates:statistics.aggregates) {
+            writeAggregates(out, aggregates);
+        }
+        out.write(static_cast<uint64_t>(statistics.skippedRows));
+        out.write(statistics.activityClasses);
+
+        out.write(trainingLoad.loads);
+        out.write(trainingLoad.days);
+        out.write(trainingLoad.firstDay);
+        out.write(static_cast<uint64_t>(trainingLoad.dirtyFrom));
+        out.write(trainingLoad.intensityFactors);
+
+        out.write(static_cast<uint64_t>(gearLedger.gears.size()));
+        for(const GearLedger::Gear& gear:gearLedger.gears) {
+            out.write(gear.total);
+            writeMap(out, gear.usageByDay);
+            out.write(static_cast<uint64_t>(gear.components.size()));
+            for(const auto& nameAndComponent:gear.components) {
+                out.write(nameAndComponent.first);
+                writeMap(out, nameAndComponent.second.services);
+                out.write(nameAndComponent.second.sinceService);
+            }
+        }
+        out.write(gearLedger.serviceActivities);
+
+        out.write(static_cast<uint64_t>(personalRecords.boards.size()));
+        for(const auto& keyAndBoard:personalRecords.boards) {
+            out.write(keyAndBoard.first);
+            out.write(keyAndBoard.second.records);
+            out.write(keyAndBoard.second.truncated);
+        }
+        out.write(personalRecords.activityClasses);
+
+        out.close();
+    }
+
+    if(rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+        remove(tmpFilePath.c_str());
+        throw EtlRuntimeException("Unable to rename analytics cache file "+tmpFilePath);
+    }
+}
+
+bool AnalyticsCache::read(
+        const string& csvFilePath,
+        uint64_t contentHash,
+        size_t rows,
+        Statistics& statistics,
+        TrainingLoad& trainingLoad,
+        GearLedger& gearLedger,
+        PersonalRecords& personalRecords)
+{
+    string filePath{cachePath(csvFilePath)};
+    if(!Dataset::file_exists(filePath)) {
+        return false;
+    }
+
+    try {
+        MappedFile cacheFile{filePath};
+        CacheReader in{filePath, cacheFile.begin(), cacheFile.end()};
+
+        Header header;
+        in.read(header);
+        if(memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0
+               || header.engineVersion != ENGINE_VERSION
+               || header.byteOrderMark != CACHE_BYTE_ORDER_MARK
+               || header.contentHash != contentHash
+               || header.rows != rows)
+        {
+            return false;
+        }
+
+        for(Statistics::Aggregates& aggregates:statistics.aggregates) {
+            readAggregates(in, aggregates);
+        }
+        uint64_t skippedRows;
+        in.read(skippedRows);
+        statistics.skippedRows = skippedRows;
+        in.read(statistics.activityClasses);
+
+        in.read(trainingLoad.loads);
+        in.read(trainingLoad.days);
+        in.read(trainingLoad.firstDay);
+        uint64_t dirtyFrom;
+        in.read(dirtyFrom);
+        trainingLoad.dirtyFrom = dirtyFrom;
+        in.read(trainingLoad.intensityFactors);
+
+        gearLedger.gears.clear();
+        gearLedger.gears.resize(in.readCount(sizeof(GearLedger::Usage)));
+        for(GearLedger::Gear& gear:gearLedger.gears) {
+            in.read(gear.total);
+            readMap(in, gear.usageByDay);
+            for(uint64_t count = in.readCount(sizeof(uint64_t)); count; count--) {
+                string name;
+                in.read(name);
+                GearLedger::Component& component = gear.components[name];
+                readMap(in, component.services);
+                in.read(component.sinceService);
+            }
+        }
+        in.read(gearLedger.serviceActivities);
+
+        personalRecords.boards.clear();
+        for(uint64_t count = in.readCount(sizeof(PersonalRecords::Key)); count; count--) {
+            PersonalRecords::Key key;
+            in.read(key);
+            PersonalRecords::Board& board = personalRecords.boards[key];
+            in.read(board.records);
+            in.read(board.truncated);
+        }
+        in.read(personalRecords.activityClasses);
+
+        if(!in.atEnd()) {
+            in.damaged();
+        }
+    } catch(EtlRuntimeException& e) {
+        cerr << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace etl76
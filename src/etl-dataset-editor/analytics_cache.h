@@ -0,0 +1,106 @@
+/*
+ analytics_cache.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_ANALYTICS_CACHE_H
+#define ETL76_ANALYTICS_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "dataset_columns.h"
+#include "exceptions.h"
+#include "gear_ledger.h"
+#include "personal_records.h"
+#include "statistics.h"
+#include "training_load.h"
+
+namespace etl76 {
+
+/**
+ * @brief Cache of calculated analytics (.etla file).
+ *
+ * Statistics, training load, gear ledger and personal records calculated
+ * from dataset columns are saved next to the CSV file w/ content hash of
+ * the columns and engine version. If the dataset is not changed, analytics
+ * are loaded from the cache instead of being calculated again.
+ *
+ * Content hash covers all columns including categorical codes and
+ * dictionaries (analytics are indexed by codes). ENGINE_VERSION must be
+ * increased whenever analytics (their calculation or members) change.
+ * Numbers are in host byte order - cache from a host w/ different byte
+ * order is not used.
+ */
+class AnalyticsCache
+{
+public:
+    static const uint32_t ENGINE_VERSION = 1;
+    static constexpr const char* FILE_EXTENSION = ".etla";
+
+    /**
+     * @brief Cache header.
+     */
+    struct Header
+    {
+        char magic[4];
+        uint32_t engineVersion;
+        uint32_t byteOrderMark;
+        uint32_t reserved;
+        uint64_t contentHash;
+        uint64_t rows;
+    };
+
+public:
+    AnalyticsCache() = delete;
+
+    static std::string cachePath(const std::string& csvFilePath);
+
+    /**
+     * @brief 64-bit hash of the content of columns (not cryptographic).
+     */
+    static uint64_t contentHash(const DatasetColumns& columns);
+
+    /**
+     * @brief Write analytics calculated from columns w/ the content hash.
+     */
+    static void write(
+            const std::string& csvFilePath,
+            uint64_t contentHash,
+            size_t rows,
+            const Statistics& statistics,
+            const TrainingLoad& trainingLoad,
+            const GearLedger& gearLedger,
+            const PersonalRecords& personalRecords);
+    /**
+     * @brief Read analytics if the cache exists and it has the content hash.
+     *
+     * Returns false if cache is missing, stale, from other engine version or
+     * damaged - analytics must be calculated then.
+     */
+    static bool read(
+            const std::string& csvFilePath,
+            uint64_t contentHash,
+            size_t rows,
+            Statistics& statistics,
+            TrainingLoad& trainingLoad,
+            GearLedger& gearLedger,
+            PersonalRecords& personalRecords);
+};
+
+} // namespace etl76
+
+#endif // ETL76_ANALYTICS_CACHE_H
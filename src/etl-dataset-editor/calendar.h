@@ -0,0 +1,97 @@
+/*
+ calendar.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_CALENDAR_H
+#define ETL76_CALENDAR_H
+
+#include <cstdint>
+
+namespace etl76 {
+
+/**
+ * @brief Calendar arithmetic.
+ *
+ * Dates are converted to day numbers (days since 1970-01-01 in proleptic
+ * Gregorian calendar) w/o a table or a library call so that it can be
+ * done for every row of a dataset scan.
+ */
+class Calendar
+{
+public:
+    Calendar() = delete;
+
+    static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year-399) / 400;
+        const unsigned yearOfEra = static_cast<unsigned>(year - era*400);
+        const unsigned dayOfYear = (153*(month > 2 ? month-3 : month+9) + 2)/5 + day-1;
+        const unsigned dayOfEra = yearOfEra*365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+        return era*146097 + static_cast<int64_t>(dayOfEra) - 719468;
+    }
+
+    static void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days-146096) / 146097;
+        const unsigned dayOfEra = static_cast<unsigned>(days - era*146097);
+        const unsigned yearOfEra = (dayOfEra - dayOfEra/1460 + dayOfEra/36524 - dayOfEra/146096) / 365;
+        const unsigned dayOfYear = dayOfEra - (365*yearOfEra + yearOfEra/4 - yearOfEra/100);
+        const unsigned monthIndex = (5*dayOfYear + 2)/153;
+        day = dayOfYear - (153*monthIndex+2)/5 + 1;
+        month = monthIndex < 10 ? monthIndex+3 : monthIndex-9;
+        year = static_cast<int64_t>(yearOfEra) + era*400 + (month <= 2);
+    }
+
+    static bool isLeapYear(int64_t year) {
+        return year%4 == 0 && (year%100 != 0 || year%400 == 0);
+    }
+
+    static unsigned daysInMonth(int64_t year, unsigned month) {
+        static const unsigned DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && isLeapYear(year) ? 29 : DAYS[month-1];
+    }
+
+    /**
+     * @brief 31st of February and friends are not valid.
+     */
+    static bool isValidDate(int64_t year, unsigned month, unsigned day) {
+        return month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month);
+    }
+
+    /**
+     * @brief Day of week: 0 is Monday, 6 is Sunday.
+     */
+    static unsigned weekday(int64_t dayNumber) {
+        // 1970-01-01 was Thursday
+        const int64_t weekday = (dayNumber+3) % 7;
+        return static_cast<unsigned>(weekday < 0 ? weekday+7 : weekday);
+    }
+
+    /**
+     * @brief ISO 8601 week: week starts on Monday and belongs to the year of its Thursday.
+     */
+    static void isoWeek(int64_t dayNumber, int64_t& isoYear, unsigned& week) {
+        const int64_t thursday = dayNumber - weekday(dayNumber) + 3;
+        unsigned month, day;
+        civilFromDays(thursday, isoYear, month, day);
+        week = static_cast<unsigned>((thursday - daysFromCivil(isoYear, 1, 1))/7 + 1);
+    }
+};
+
+} // namespace etl76
+
+#endif // ETL76_CALENDAR_H
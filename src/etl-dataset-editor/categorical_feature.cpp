@@ -0,0 +1,91 @@
+/*
+ categorical_feature.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "categorical_feature.h"
+
+namespace etl76 {
+
+using namespace std;
+
+// codes are passed by reference (fill(), emplace())
+const unsigned CategoricalFeature::NO_CODE;
+const unsigned CategoricalFeature::EMPTY_CODE;
+
+CategoricalFeature::CategoricalFeature()
+{
+    clear();
+}
+
+unsigned CategoricalFeature::intern(string_view utf8Value)
+{
+    // SSO: short values (most of them) are looked up w/o allocation
+    string key{utf8Value};
+    auto found = codes.find(key);
+    if(found != codes.end()) {
+        return found->second;
+    }
+
+    unsigned code = static_cast<unsigned>(values.size());
+    values.push_back(QString::fromUtf8(utf8Value.data(), static_cast<int>(utf8Value.size())));
+    utf8Values.push_back(&codes.emplace(std::move(key), code).first->first);
+    return code;
+}
+
+unsigned CategoricalFeature::find(const QString& value) const
+{
+    auto found = codes.find(value.toUtf8().constData());
+    if(found != codes.end()) {
+        return found->second;
+    }
+    return NO_CODE;
+}
+
+size_t CategoricalFeature::getByteSize() const
+{
+    size_t bytes = values.capacity()*sizeof(QString) + utf8Values.capacity()*sizeof(const string*);
+    for(const QString& value:values) {
+        bytes += value.size()*sizeof(QChar);
+    }
+    for(const auto& code:codes) {
+        bytes += sizeof(code) + code.first.capacity();
+    }
+    return bytes;
+}
+
+void CategoricalFeature::clear()
+{
+    values.clear();
+    codes.clear();
+    utf8Values.clear();
+
+    values.push_back(QString{});
+    utf8Values.push_back(&codes.emplace(string{}, EMPTY_CODE).first->first);
+}
+
+void CategoricalFeature::assign(const CategoricalFeature& src)
+{
+    // QStrings are implicitly shared
+    values = src.values;
+    codes = src.codes;
+    utf8Values.resize(values.size());
+    for(const auto& code:codes) {
+        utf8Values[code.second] = &code.first;
+    }
+}
+
+} // namespace etl76
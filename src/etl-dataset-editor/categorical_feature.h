@@ -0,0 +1,119 @@
+/*
+ categorical_feature.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_CATEGORICAL_FEATURE_H
+#define ETL76_CATEGORICAL_FEATURE_H
+
+#include <climits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+
+namespace etl76 {
+
+/**
+ * @brief Categorical feature.
+ *
+ * Dictionary of (interned) values of a categorical feature like activity
+ * or gear. Every distinct value is stored once and rows store its small
+ * integer code: codes are dense (0..size-1) so that group-bys can index
+ * arrays directly. Code 0 is always empty value.
+ */
+class CategoricalFeature
+{
+public:
+    static const unsigned NO_CODE = UINT_MAX;
+    static const unsigned EMPTY_CODE = 0;
+
+private:
+    std::vector<QString> values;
+    // UTF-8 value to code: parser interns values w/o QString conversion
+    std::unordered_map<std::string, unsigned> codes;
+    // code to UTF-8 value (key in codes): writer copies values w/o conversion
+    std::vector<const std::string*> utf8Values;
+
+public:
+    CategoricalFeature();
+    CategoricalFeature(const CategoricalFeature&) = delete;
+    CategoricalFeature(const CategoricalFeature&&) = delete;
+    CategoricalFeature &operator=(const CategoricalFeature&) = delete;
+    CategoricalFeature &operator=(const CategoricalFeature&&) = delete;
+
+    unsigned intern(std::string_view utf8Value);
+    unsigned intern(const char* utf8Value) {
+        return intern(std::string_view{utf8Value});
+    }
+    unsigned intern(const QString& value) {
+        return intern(value.toUtf8().constData());
+    }
+    /**
+     * @brief Find code of the value, NO_CODE if value is not in dictionary.
+     */
+    unsigned find(const QString& value) const;
+
+    const QString& getValue(unsigned code) const { return values[code]; }
+    const std::string& getUtf8Value(unsigned code) const { return *utf8Values[code]; }
+    const std::vector<QString>& getValues() const { return values; }
+    size_t size() const { return values.size(); }
+    size_t getByteSize() const;
+
+    void clear();
+    /**
+     * @brief Copy values of other feature - codes are preserved.
+     */
+    void assign(const CategoricalFeature& src);
+};
+
+/**
+ * @brief Categorical value.
+ *
+ * Value of categorical feature represented by dictionary code.
+ */
+class CategoricalValue
+{
+private:
+    const CategoricalFeature* feature;
+    unsigned code;
+
+public:
+    CategoricalValue(const CategoricalFeature* feature, unsigned code)
+        : feature(feature),
+          code(code)
+    {}
+
+    const CategoricalFeature* getFeature() const { return feature; }
+    unsigned getCode() const { return code; }
+
+    QString toString() const { return feature->getValue(code); }
+
+    bool operator==(const CategoricalValue& other) const {
+        if(feature == other.feature) {
+            return code == other.code;
+        }
+        return toString() == other.toString();
+    }
+    bool operator!=(const CategoricalValue& other) const {
+        return !(*this == other);
+    }
+};
+
+} // namespace etl76
+
+#endif // ETL76_CATEGORICAL_FEATURE_H
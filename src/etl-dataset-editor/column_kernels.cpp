@@ -0,0 +1,603 @@
+/*
+ column_kernels.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "column_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if !defined(ETL76_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define ETL76_SIMD_X86
+  #include <immintrin.h>
+#endif
+
+namespace etl76 {
+
+using namespace std;
+
+/*
+ * Scalar
+ */
+
+/*
+ * Summary is accumulated in locals: values may alias its fields and so they
+ * would be stored on every value.
+ */
+template<class T, class S>
+static void summarizeScalar(const T* values, size_t size, const unsigned char* mask, S& s)
+{
+    auto sum = s.sum;
+    T minimum = s.min;
+    T maximum = s.max;
+    size_t count = s.count;
+    if(mask) {
+        for(size_t i=0; i<size; i++) {
+            if(mask[i]) {
+                sum += values[i];
+                minimum = min(minimum, values[i]);
+                maximum = max(maximum, values[i]);
+                count++;
+            }
+        }
+    } else {
+        for(size_t i=0; i<size; i++) {
+            sum += values[i];
+            minimum = min(minimum, values[i]);
+            maximum = max(maximum, values[i]);
+        }
+        count += size;
+    }
+    s.sum = sum;
+    s.min = minimum;
+    s.max = maximum;
+    s.count = count;
+}
+
+static void maskEqualScalar(const unsigned* values, size_t size, unsigned value, unsigned char* mask)
+{
+    for(size_t i=0; i<size; i++) {
+        mask[i] = values[i] == value;
+    }
+}
+
+static void maskNonZeroScalar(const unsigned* values, size_t size, unsigned char* mask)
+{
+    for(size_t i=0; i<size; i++) {
+        mask[i] = values[i] != 0;
+    }
+}
+
+static void maskPositiveScalar(const float* values, size_t size, unsigned char* mask)
+{
+    for(size_t i=0; i<size; i++) {
+        mask[i] = values[i] > 0;
+    }
+}
+
+#ifdef ETL76_SIMD_X86
+
+/*
+ * SSE4.1: 4 values per instruction
+ */
+
+__attribute__((target("sse4.1")))
+static void summarizeSse41(const unsigned* values, size_t size, const unsigned char* mask, ColumnKernels::UIntSummary& s)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    __m128i sum = zero;
+    __m128i minimum = ones;
+    __m128i maximum = zero;
+    __m128i count = zero;
+
+    size_t i = 0;
+    for(; i+4 <= size; i+=4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values+i));
+        if(mask) {
+            int32_t maskBytes;
+            memcpy(&maskBytes, mask+i, sizeof(maskBytes));
+            const __m128i m = _mm_cmpgt_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(maskBytes)), zero);
+            count = _mm_sub_epi32(count, m);
+            // unselected values are neutral: max for min and 0 for max and sum
+            minimum = _mm_min_epu32(minimum, _mm_or_si128(x, _mm_andnot_si128(m, ones)));
+            x = _mm_and_si128(x, m);
+        } else {
+            minimum = _mm_min_epu32(minimum, x);
+        }
+        maximum = _mm_max_epu32(maximum, x);
+        sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(x));
+        sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(_mm_srli_si128(x, 8)));
+    }
+
+    uint64_t sums[2];
+    unsigned minimums[4], maximums[4], counts[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sum);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(minimums), minimum);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(maximums), maximum);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counts), count);
+    s.sum += sums[0] + sums[1];
+    for(int lane=0; lane<4; lane++) {
+        s.min = min(s.min, minimums[lane]);
+        s.max = max(s.max, maximums[lane]);
+        s.count += mask ? counts[lane] : 0;
+    }
+    if(!mask) {
+        s.count += i;
+    }
+    summarizeScalar(values+i, size-i, mask ? mask+i : nullptr, s);
+}
+
+__attribute__((target("sse4.1")))
+static void summarizeSse41(const float* values, size_t size, const unsigned char* mask, ColumnKernels::FloatSummary& s)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128d sumLow = _mm_setzero_pd();
+    __m128d sumHigh = _mm_setzero_pd();
+    __m128 minimum = _mm_set1_ps(numeric_limits<float>::infinity());
+    __m128 maximum = _mm_set1_ps(-numeric_limits<float>::infinity());
+    __m128i count = zero;
+
+    size_t i = 0;
+    for(; i+4 <= size; i+=4) {
+        __m128 x = _mm_loadu_ps(values+i);
+        if(mask) {
+            int32_t maskBytes;
+            memcpy(&maskBytes, mask+i, sizeof(maskBytes));
+            const __m128i mi = _mm_cmpgt_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(maskBytes)), zero);
+            const __m128 m = _mm_castsi128_ps(mi);
+            count = _mm_sub_epi32(count, mi);
+            minimum = _mm_min_ps(minimum, _mm_blendv_ps(_mm_set1_ps(numeric_limits<float>::infinity()), x, m));
+            maximum = _mm_max_ps(maximum, _mm_blendv_ps(_mm_set1_ps(-numeric_limits<float>::infinity()), x, m));
+            x = _mm_and_ps(x, m);
+        } else {
+            minimum = _mm_min_ps(minimum, x);
+            maximum = _mm_max_ps(maximum, x);
+        }
+        sumLow = _mm_add_pd(sumLow, _mm_cvtps_pd(x));
+        sumHigh = _mm_add_pd(sumHigh, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+
+    double sums[2];
+    float minimums[4], maximums[4];
+    unsigned counts[4];
+    _mm_storeu_pd(sums, _mm_add_pd(sumLow, sumHigh));
+    _mm_storeu_ps(minimums, minimum);
+    _mm_storeu_ps(maximums, maximum);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counts), count);
+    s.sum += sums[0] + sums[1];
+    for(int lane=0; lane<4; lane++) {
+        s.min = min(s.min, minimums[lane]);
+        s.max = max(s.max, maximums[lane]);
+        s.count += mask ? counts[lane] : 0;
+    }
+    if(!mask) {
+        s.count += i;
+    }
+    summarizeScalar(values+i, size-i, mask ? mask+i : nullptr, s);
+}
+
+/*
+ * 16 lanes of 0/-1 are packed to 16 mask bytes of 0/1.
+ */
+__attribute__((target("sse4.1")))
+static inline void storeMaskSse41(unsigned char* mask, __m128i c0, __m128i c1, __m128i c2, __m128i c3)
+{
+    const __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mask), _mm_and_si128(bytes, _mm_set1_epi8(1)));
+}
+
+__attribute__((target("sse4.1")))
+static void maskEqualSse41(const unsigned* values, size_t size, unsigned value, unsigned char* mask)
+{
+    const __m128i v = _mm_set1_epi32(static_cast<int>(value));
+    size_t i = 0;
+    for(; i+16 <= size; i+=16) {
+        const __m128i* x = reinterpret_cast<const __m128i*>(values+i);
+        storeMaskSse41(
+            mask+i,
+            _mm_cmpeq_epi32(_mm_loadu_si128(x), v),
+            _mm_cmpeq_epi32(_mm_loadu_si128(x+1), v),
+            _mm_cmpeq_epi32(_mm_loadu_si128(x+2), v),
+            _mm_cmpeq_epi32(_mm_loadu_si128(x+3), v));
+    }
+    maskEqualScalar(values+i, size-i, value, mask+i);
+}
+
+__attribute__((target("sse4.1")))
+static void maskNonZeroSse41(const unsigned* values, size_t size, unsigned char* mask)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    size_t i = 0;
+    for(; i+16 <= size; i+=16) {
+        const __m128i* x = reinterpret_cast<const __m128i*>(values+i);
+        storeMaskSse41(
+            mask+i,
+            _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128(x), zero), ones),
+            _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128(x+1), zero), ones),
+            _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128(x+2), zero), ones),
+            _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128(x+3), zero), ones));
+    }
+    maskNonZeroScalar(values+i, size-i, mask+i);
+}
+
+__attribute__((target("sse4.1")))
+static void maskPositiveSse41(const float* values, size_t size, unsigned char* mask)
+{
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for(; i+16 <= size; i+=16) {
+        storeMaskSse41(
+            mask+i,
+            _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(values+i), zero)),
+            _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(values+i+4), zero)),
+            _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(values+i+8), zero)),
+            _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(values+i+12), zero)));
+    }
+    maskPositiveScalar(values+i, size-i, mask+i);
+}
+
+/*
+ * AVX2: 8 values per instruction
+ */
+
+__attribute__((target("avx2")))
+static void summarizeAvx2(const unsigned* values, size_t size, const unsigned char* mask, ColumnKernels::UIntSummary& s)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i sum = zero;
+    __m256i minimum = ones;
+    __m256i maximum = zero;
+    __m256i count = zero;
+
+    size_t i = 0;
+    for(; i+8 <= size; i+=8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values+i));
+        if(mask) {
+            const __m256i m = _mm256_cmpgt_epi32(
+                _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask+i))),
+                zero);
+            count = _mm256_sub_epi32(count, m);
+            // unselected values are neutral: max for min and 0 for max and sum
+            minimum = _mm256_min_epu32(minimum, _mm256_or_si256(x, _mm256_andnot_si256(m, ones)));
+            x = _mm256_and_si256(x, m);
+        } else {
+            minimum = _mm256_min_epu32(minimum, x);
+        }
+        maximum = _mm256_max_epu32(maximum, x);
+        sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(x)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+
+    uint64_t sums[4];
+    unsigned minimums[8], maximums[8], counts[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(minimums), minimum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(maximums), maximum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), count);
+    s.sum += sums[0] + sums[1] + sums[2] + sums[3];
+    for(int lane=0; lane<8; lane++) {
+        s.min = min(s.min, minimums[lane]);
+        s.max = max(s.max, maximums[lane]);
+        s.count += mask ? counts[lane] : 0;
+    }
+    if(!mask) {
+        s.count += i;
+    }
+    summarizeScalar(values+i, size-i, mask ? mask+i : nullptr, s);
+}
+
+__attribute__((target("avx2")))
+static void summarizeAvx2(const float* values, size_t size, const unsigned char* mask, ColumnKernels::FloatSummary& s)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256 positiveInfinity = _mm256_set1_ps(numeric_limits<float>::infinity());
+    const __m256 negativeInfinity = _mm256_set1_ps(-numeric_limits<float>::infinity());
+    __m256d sumLow = _mm256_setzero_pd();
+    __m256d sumHigh = _mm256_setzero_pd();
+    __m256 minimum = positiveInfinity;
+    __m256 maximum = negativeInfinity;
+    __m256i count = zero;
+
+    size_t i = 0;
+    for(; i+8 <= size; i+=8) {
+        __m256 x = _mm256_loadu_ps(values+i);
+        if(mask) {
+            const __m256i mi = _mm256_cmpgt_epi32(
+                _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask+i))),
+                zero);
+            const __m256 m = _mm256_castsi256_ps(mi);
+            count = _mm256_sub_epi32(count, mi);
+            minimum = _mm256_min_ps(minimum, _mm256_blendv_ps(positiveInfinity, x, m));
+            maximum = _mm256_max_ps(maximum, _mm256_blendv_ps(negativeInfinity, x, m));
+            x = _mm256_and_ps(x, m);
+        } else {
+            minimum = _mm256_min_ps(minimum, x);
+            maximum = _mm256_max_ps(maximum, x);
+        }
+        sumLow = _mm256_add_pd(sumLow, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        sumHigh = _mm256_add_pd(sumHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+
+    double sums[4];
+    float minimums[8], maximums[8];
+    unsigned counts[8];
+    _mm256_storeu_pd(sums, _mm256_add_pd(sumLow, sumHigh));
+    _mm256_storeu_ps(minimums, minimum);
+    _mm256_storeu_ps(maximums, maximum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), count);
+    s.sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    for(int lane=0; lane<8; lane++) {
+        s.min = min(s.min, minimums[lane]);
+        s.max = max(s.max, maximums[lane]);
+        s.count += mask ? counts[lane] : 0;
+    }
+    if(!mask) {
+        s.count += i;
+    }
+    summarizeScalar(values+i, size-i, mask ? mask+i : nullptr, s);
+}
+
+/*
+ * 32 lanes of 0/-1 are packed to 32 mask bytes of 0/1 - packs work within
+ * 128b lanes, so 4B groups are permuted back to the row order.
+ */
+__attribute__((target("avx2")))
+static inline void storeMaskAvx2(unsigned char* mask, __m256i c0, __m256i c1, __m256i c2, __m256i c3)
+{
+    const __m256i bytes = _mm256_packs_epi16(_mm256_packs_epi32(c0, c1), _mm256_packs_epi32(c2, c3));
+    const __m256i ordered = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask), _mm256_and_si256(ordered, _mm256_set1_epi8(1)));
+}
+
+__attribute__((target("avx2")))
+static void maskEqualAvx2(const unsigned* values, size_t size, unsigned value, unsigned char* mask)
+{
+    const __m256i v = _mm256_set1_epi32(static_cast<int>(value));
+    size_t i = 0;
+    for(; i+32 <= size; i+=32) {
+        const __m256i* x = reinterpret_cast<const __m256i*>(values+i);
+        storeMaskAvx2(
+            mask+i,
+            _mm256_cmpeq_epi32(_mm256_loadu_si256(x), v),
+            _mm256_cmpeq_epi32(_mm256_loadu_si256(x+1), v),
+            _mm256_cmpeq_epi32(_mm256_loadu_si256(x+2), v),
+            _mm256_cmpeq_epi32(_mm256_loadu_si256(x+3), v));
+    }
+    maskEqualScalar(values+i, size-i, value, mask+i);
+}
+
+__attribute__((target("avx2")))
+static void maskNonZeroAvx2(const unsigned* values, size_t size, unsigned char* mask)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for(; i+32 <= size; i+=32) {
+        const __m256i* x = reinterpret_cast<const __m256i*>(values+i);
+        storeMaskAvx2(
+            mask+i,
+            _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(x), zero), ones),
+            _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(x+1), zero), ones),
+            _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(x+2), zero), ones),
+            _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(x+3), zero), ones));
+    }
+    maskNonZeroScalar(values+i, size-i, mask+i);
+}
+
+__attribute__((target("avx2")))
+static void maskPositiveAvx2(const float* values, size_t size, unsigned char* mask)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for(; i+32 <= size; i+=32) {
+        storeMaskAvx2(
+            mask+i,
+            _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(values+i), zero, _CMP_GT_OQ)),
+            _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(values+i+8), zero, _CMP_GT_OQ)),
+            _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(values+i+16), zero, _CMP_GT_OQ)),
+            _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(values+i+24), zero, _CMP_GT_OQ)));
+    }
+    maskPositiveScalar(values+i, size-i, mask+i);
+}
+
+#endif // ETL76_SIMD_X86
+
+/*
+ * Dispatch
+ */
+
+ColumnKernels::InstructionSet ColumnKernels::getSupportedInstructionSet()
+{
+#ifdef ETL76_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return InstructionSet::AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1")) {
+        return InstructionSet::SSE41;
+    }
+#endif
+    return InstructionSet::SCALAR;
+}
+
+ColumnKernels::InstructionSet ColumnKernels::instructionSet = ColumnKernels::getSupportedInstructionSet();
+
+void ColumnKernels::useInstructionSet(InstructionSet instructionSet)
+{
+    ColumnKernels::instructionSet = min(instructionSet, getSupportedInstructionSet());
+}
+
+ColumnKernels::UIntSummary ColumnKernels::summarize(const unsigned* values, size_t size, const unsigned char* mask)
+{
+    UIntSummary s{0, numeric_limits<unsigned>::max(), 0, 0};
+    switch(instructionSet) {
+#ifdef ETL76_SIMD_X86
+    case InstructionSet::AVX2:
+        summarizeAvx2(values, size, mask, s);
+        break;
+    case InstructionSet::SSE41:
+        summarizeSse41(values, size, mask, s);
+        break;
+#endif
+    default:
+        summarizeScalar(values, size, mask, s);
+    }
+    if(!s.count) {
+        s.min = s.max = 0;
+    }
+    return s;
+}
+
+ColumnKernels::FloatSummary ColumnKernels::summarize(const float* values, size_t size, const unsigned char* mask)
+{
+    FloatSummary s{0, numeric_limits<float>::infinity(), -numeric_limits<float>::infinity(), 0};
+    switch(instructionSet) {
+#ifdef ETL76_SIMD_X86
+    case InstructionSet::AVX2:
+        summarizeAvx2(values, size, mask, s);
+        break;
+    case InstructionSet::SSE41:
+        summarizeSse41(values, size, mask, s);
+        break;
+#endif
+    default:
+        summarizeScalar(values, size, mask, s);
+    }
+    if(!s.count) {
+        s.min = s.max = 0;
+    }
+    return s;
+}
+
+void ColumnKernels::maskEqual(const unsigned* values, size_t size, unsigned value, unsigned char* mask)
+{
+    switch(instructionSet) {
+#ifdef ETL76_SIMD_X86
+    case InstructionSet::AVX2:
+        maskEqualAvx2(values, size, value, mask);
+        break;
+    case InstructionSet::SSE41:
+        maskEqualSse41(values, size, value, mask);
+        break;
+#endif
+    default:
+        maskEqualScalar(values, size, value, mask);
+    }
+}
+
+void ColumnKernels::maskNonZero(const unsigned* values, size_t size, unsigned char* mask)
+{
+    switch(instructionSet) {
+#ifdef ETL76_SIMD_X86
+    case InstructionSet::AVX2:
+        maskNonZeroAvx2(values, size, mask);
+        break;
+    case InstructionSet::SSE41:
+        maskNonZeroSse41(values, size, mask);
+        break;
+#endif
+    default:
+        maskNonZeroScalar(values, size, mask);
+    }
+}
+
+void ColumnKernels::maskPositive(const float* values, size_t size, unsigned char* mask)
+{
+    switch(instructionSet) {
+#ifdef ETL76_SIMD_X86
+    case InstructionSet::AVX2:
+        maskPositiveAvx2(values, size, mask);
+        break;
+    case InstructionSet::SSE41:
+        maskPositiveSse41(values, size, mask);
+        break;
+#endif
+    default:
+        maskPositiveScalar(values, size, mask);
+    }
+}
+
+void ColumnKernels::maskAnd(unsigned char* mask, const unsigned char* other, size_t size)
+{
+    // mask bytes are 0/1: 8 rows per 64b word on any CPU
+    size_t i = 0;
+    for(; i+8 <= size; i+=8) {
+        uint64_t a, b;
+        memcpy(&a, mask+i, sizeof(a));
+        memcpy(&b, other+i, sizeof(b));
+        a &= b;
+        memcpy(mask+i, &a, sizeof(a));
+    }
+    for(; i<size; i++) {
+        mask[i] &= other[i];
+    }
+}
+
+/*
+ * Columns
+ */
+
+ColumnKernels::UIntSummary ColumnKernels::summarize(
+        const DatasetColumns& columns,
+        DatasetColumns::UIntColumn column,
+        const Mask* mask)
+{
+    const vector<unsigned>& values = columns.getColumn(column);
+    return summarize(values.data(), values.size(), mask ? mask->data() : nullptr);
+}
+
+ColumnKernels::FloatSummary ColumnKernels::summarize(
+        const DatasetColumns& columns,
+        DatasetColumns::FloatColumn column,
+        const Mask* mask)
+{
+    const vector<float>& values = columns.getColumn(column);
+    return summarize(values.data(), values.size(), mask ? mask->data() : nullptr);
+}
+
+ColumnKernels::Mask ColumnKernels::maskEqual(
+        const DatasetColumns& columns,
+        DatasetColumns::CategoricalColumn column,
+        unsigned code)
+{
+    const vector<unsigned>& codes = columns.getColumn(column);
+    Mask mask(codes.size());
+    maskEqual(codes.data(), codes.size(), code, mask.data());
+    return mask;
+}
+
+ColumnKernels::Mask ColumnKernels::maskNonZero(const DatasetColumns& columns, DatasetColumns::UIntColumn column)
+{
+    const vector<unsigned>& values = columns.getColumn(column);
+    Mask mask(values.size());
+    maskNonZero(values.data(), values.size(), mask.data());
+    return mask;
+}
+
+ColumnKernels::Mask ColumnKernels::maskPositive(const DatasetColumns& columns, DatasetColumns::FloatColumn column)
+{
+    const vector<float>& values = columns.getColumn(column);
+    Mask mask(values.size());
+    maskPositive(values.data(), values.size(), mask.data());
+    return mask;
+}
+
+} // namespace etl76
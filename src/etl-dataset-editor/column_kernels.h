@@ -0,0 +1,139 @@
+/*
+ column_kernels.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_COLUMN_KERNELS_H
+#define ETL76_COLUMN_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "dataset_columns.h"
+
+namespace etl76 {
+
+/**
+ * @brief Vectorized kernels over contiguous columns.
+ *
+ * Sum, min, max, count (and mean) of a numeric column, optionally of the
+ * rows selected by a mask only. Mask has a byte per row: non-zero byte
+ * selects the row. Masks are built by kernels too (activity == ride,
+ * commute, ...) and combined w/ maskAnd().
+ *
+ * Kernels are implemented for AVX2, SSE4.1 and scalar - the best instruction
+ * set supported by the CPU is chosen at runtime. Define ETL76_NO_SIMD to
+ * build scalar kernels only.
+ *
+ * Float column is summed in double: sum (and so mean) may differ in the
+ * last bits between instruction sets as the order of additions differs.
+ */
+class ColumnKernels
+{
+public:
+    enum class InstructionSet {
+        SCALAR,
+        SSE41,
+        AVX2
+    };
+
+    typedef std::vector<unsigned char> Mask;
+
+    /**
+     * @brief Summary of unsigned values - min and max are 0 if count is 0.
+     */
+    struct UIntSummary {
+        uint64_t sum;
+        unsigned min;
+        unsigned max;
+        size_t count;
+
+        double getMean() const { return count ? static_cast<double>(sum)/count : 0; }
+    };
+
+    /**
+     * @brief Summary of float values - min and max are 0 if count is 0.
+     */
+    struct FloatSummary {
+        double sum;
+        float min;
+        float max;
+        size_t count;
+
+        double getMean() const { return count ? sum/count : 0; }
+    };
+
+private:
+    static InstructionSet instructionSet;
+
+public:
+    ColumnKernels() = delete;
+
+    /**
+     * @brief Instruction set used by kernels.
+     */
+    static InstructionSet getInstructionSet() { return instructionSet; }
+    static InstructionSet getSupportedInstructionSet();
+    /**
+     * @brief Use given instruction set (if supported) - for comparison of kernels.
+     */
+    static void useInstructionSet(InstructionSet instructionSet);
+
+    /*
+     * Raw arrays
+     */
+
+    static UIntSummary summarize(const unsigned* values, size_t size, const unsigned char* mask = nullptr);
+    static FloatSummary summarize(const float* values, size_t size, const unsigned char* mask = nullptr);
+
+    static void maskEqual(const unsigned* values, size_t size, unsigned value, unsigned char* mask);
+    static void maskNonZero(const unsigned* values, size_t size, unsigned char* mask);
+    static void maskPositive(const float* values, size_t size, unsigned char* mask);
+    /**
+     * @brief Intersect mask w/ other mask.
+     */
+    static void maskAnd(unsigned char* mask, const unsigned char* other, size_t size);
+
+    /*
+     * Columns
+     */
+
+    static UIntSummary summarize(
+            const DatasetColumns& columns,
+            DatasetColumns::UIntColumn column,
+            const Mask* mask = nullptr);
+    static FloatSummary summarize(
+            const DatasetColumns& columns,
+            DatasetColumns::FloatColumn column,
+            const Mask* mask = nullptr);
+
+    /**
+     * @brief Rows w/ categorical value code, e.g. activity == ride.
+     */
+    static Mask maskEqual(const DatasetColumns& columns, DatasetColumns::CategoricalColumn column, unsigned code);
+    /**
+     * @brief Rows w/ non-zero value, e.g. commute.
+     */
+    static Mask maskNonZero(const DatasetColumns& columns, DatasetColumns::UIntColumn column);
+    /**
+     * @brief Rows w/ positive value, e.g. weight which is set.
+     */
+    static Mask maskPositive(const DatasetColumns& columns, DatasetColumns::FloatColumn column);
+};
+
+} // namespace etl76
+
+#endif // ETL76_COLUMN_KERNELS_H
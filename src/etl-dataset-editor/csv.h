@@ -40,14 +40,37 @@
 #include <cstdio>
 #include <exception>
 #ifndef CSV_IO_NO_THREAD
-#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <thread>
-#include <condition_variable>
 #endif
 #include <memory>
 #include <cassert>
 #include <cerrno>
+#include <charconv>
+#include <cstdint>
 #include <istream>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+// size of blocks read from the byte source (and the maximum line length)
+#ifndef CSV_IO_BLOCK_LEN
+#define CSV_IO_BLOCK_LEN (1<<20)
+#endif
+// number of blocks read ahead by the reader thread (unless CSV_IO_NO_THREAD)
+#ifndef CSV_IO_READ_AHEAD_BLOCKS
+#define CSV_IO_READ_AHEAD_BLOCKS 4
+#endif
+// define CSV_IO_NO_SIMD to scan columns and validate UTF-8 byte by byte
+#if !defined(CSV_IO_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define CSV_IO_SIMD
+#define CSV_IO_SIMD_AVX2
+#elif !defined(CSV_IO_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CSV_IO_SIMD
+#define CSV_IO_SIMD_SSE2
+#endif
 
 namespace io{
         ////////////////////////////////////////////////////////////////////////////
@@ -135,6 +158,17 @@ namespace io{
                                         , file_line, file_name);
                         }
                 };
+
+                struct invalid_utf8 :
+                        base,
+                        with_file_name,
+                        with_file_line{
+                        void format_error_message()const override{
+                                std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                        "Line number %d in file \"%s\" is not valid UTF-8."
+                                        , file_line, file_name);
+                        }
+                };
         }
 
         class ByteSourceBase{
@@ -201,123 +235,256 @@ namespace io{
                 };
 
                 #ifndef CSV_IO_NO_THREAD
+                // Worker thread reads blocks ahead to a ring of CSV_IO_READ_AHEAD_BLOCKS
+                // while the parser consumes them. The ring has a single producer and a
+                // single consumer, so that two counters of blocks (each written by
+                // one side) hand the blocks over w/o a lock. A side which has to wait
+                // (ring is full or empty) yields and then sleeps briefly.
                 class AsynchronousReader{
                 public:
-                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source){
-                                std::unique_lock<std::mutex>guard(lock);
+                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source, int arg_block_len){
                                 byte_source = std::move(arg_byte_source);
-                                desired_byte_count = -1;
-                                termination_requested = false;
-                                worker = std::thread(
-                                        [&]{
-                                                std::unique_lock<std::mutex>guard(lock);
-                                                try{
-                                                        for(;;){
-                                                                read_requested_condition.wait(
-                                                                        guard, 
-                                                                        [&]{
-                                                                                return desired_byte_count != -1 || termination_requested;
-                                                                        }
-                                                                );
-                                                                if(termination_requested)
-                                                                        return;
-
-                                                                read_byte_count = byte_source->read(buffer, desired_byte_count);
-                                                                desired_byte_count = -1;
-                                                                if(read_byte_count == 0)
-                                                                        break;
-                                                                read_finished_condition.notify_one();
-                                                        }
-                                                }catch(...){
-                                                        read_error = std::current_exception();
-                                                }
-                                                read_finished_condition.notify_one();
-                                        }
-                                );
+                                block_len = arg_block_len;
+                                blocks = std::unique_ptr<char[]>(new char[static_cast<std::size_t>(block_count)*block_len]);
+                                filled_count.store(0, std::memory_order_relaxed);
+                                consumed_count.store(0, std::memory_order_relaxed);
+                                termination_requested.store(false, std::memory_order_relaxed);
+                                finished = false;
+                                worker = std::thread([this]{ read_ahead(); });
                         }
 
                         bool is_valid()const{
                                 return byte_source != nullptr;
                         }
 
-                        void start_read(char*arg_buffer, int arg_desired_byte_count){
-                                std::unique_lock<std::mutex>guard(lock);
-                                buffer = arg_buffer;
-                                desired_byte_count = arg_desired_byte_count;
-                                read_byte_count = -1;
-                                read_requested_condition.notify_one();
-                        }
-
-                        int finish_read(){
-                                std::unique_lock<std::mutex>guard(lock);
-                                read_finished_condition.wait(
-                                        guard, 
-                                        [&]{
-                                                return read_byte_count != -1 || read_error;
-                                        }
-                                );
-                                if(read_error)
-                                        std::rethrow_exception(read_error);
-                                else
-                                        return read_byte_count;
+                        // Copies the next block to the buffer and returns its byte count,
+                        // 0 once the byte source is exhausted.
+                        int read(char*buffer){
+                                if(finished)
+                                        return 0;
+                                unsigned consumed = consumed_count.load(std::memory_order_relaxed);
+                                for(unsigned round = 0; filled_count.load(std::memory_order_acquire) == consumed; ++round)
+                                        back_off(round);
+                                int byte_count = byte_counts[consumed % block_count];
+                                if(byte_count <= 0){
+                                        // the worker has stopped
+                                        finished = true;
+                                        if(byte_count < 0)
+                                                std::rethrow_exception(read_error);
+                                        return 0;
+                                }
+                                std::memcpy(buffer, block(consumed), byte_count);
+                                consumed_count.store(consumed+1, std::memory_order_release);
+                                return byte_count;
                         }
 
                         ~AsynchronousReader(){
                                 if(byte_source != nullptr){
-                                        {
-                                                std::unique_lock<std::mutex>guard(lock);
-                                                termination_requested = true;
-                                        }
-                                        read_requested_condition.notify_one();
+                                        termination_requested.store(true, std::memory_order_release);
                                         worker.join();
                                 }
                         }
 
-                private:           
+                private:
+                        static const int block_count = CSV_IO_READ_AHEAD_BLOCKS;
+
                         std::unique_ptr<ByteSourceBase>byte_source;
 
                         std::thread worker;
 
-                        bool termination_requested;
+                        std::unique_ptr<char[]>blocks;
+                        int block_len;
+                        // bytes read to the block, 0 at the end and -1 on read error
+                        int byte_counts[block_count];
                         std::exception_ptr read_error;
-                        char*buffer;
-                        int desired_byte_count;
-                        int read_byte_count;
+                        // blocks filled by the worker / consumed by the parser so far
+                        std::atomic<unsigned> filled_count;
+                        std::atomic<unsigned> consumed_count;
+                        std::atomic<bool> termination_requested;
+                        bool finished;
+
+                        char*block(unsigned index){
+                                return blocks.get() + static_cast<std::size_t>(index % block_count)*block_len;
+                        }
 
-                        std::mutex lock;
-                        std::condition_variable read_finished_condition;
-                        std::condition_variable read_requested_condition;  
+                        static void back_off(unsigned round){
+                                if(round < 64)
+                                        std::this_thread::yield();
+                                else
+                                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                        }
+
+                        void read_ahead(){
+                                for(unsigned filled = 0;; ++filled){
+                                        for(unsigned round = 0; filled - consumed_count.load(std::memory_order_acquire) == block_count; ++round){
+                                                if(termination_requested.load(std::memory_order_acquire))
+                                                        return;
+                                                back_off(round);
+                                        }
+                                        if(termination_requested.load(std::memory_order_acquire))
+                                                return;
+
+                                        int byte_count;
+                                        try{
+                                                byte_count = byte_source->read(block(filled), block_len);
+                                        }catch(...){
+                                                read_error = std::current_exception();
+                                                byte_count = -1;
+                                        }
+                                        byte_counts[filled % block_count] = byte_count;
+                                        filled_count.store(filled+1, std::memory_order_release);
+                                        if(byte_count <= 0)
+                                                return;
+                                }
+                        }
                 };
                 #endif
 
                 class SynchronousReader{
                 public:
-                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source){
+                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source, int arg_block_len){
                                 byte_source = std::move(arg_byte_source);
+                                block_len = arg_block_len;
                         }
 
                         bool is_valid()const{
                                 return byte_source != nullptr;
                         }
 
-                        void start_read(char*arg_buffer, int arg_desired_byte_count){
-                                buffer = arg_buffer;
-                                desired_byte_count = arg_desired_byte_count;
-                        }
-
-                        int finish_read(){
-                                return byte_source->read(buffer, desired_byte_count);
+                        int read(char*buffer){
+                                return byte_source->read(buffer, block_len);
                         }
                 private:
                         std::unique_ptr<ByteSourceBase>byte_source;
-                        char*buffer;
-                        int desired_byte_count;
+                        int block_len;
                 };
+
+                // Bytes are scanned by blocks of SIMD register width (32 bytes w/ AVX2,
+                // 16 bytes w/ SSE2): comparison of a block with a byte is reduced to
+                // a mask w/ bit i set if byte i of the block matches.
+                #if defined(CSV_IO_SIMD_AVX2)
+                typedef __m256i simd_block;
+                const int simd_width = 32;
+
+                inline simd_block simd_load(const char*p){
+                        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                }
+
+                inline simd_block simd_splat(char c){
+                        return _mm256_set1_epi8(c);
+                }
+
+                inline unsigned simd_equal(simd_block block, simd_block c){
+                        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, c)));
+                }
+
+                inline unsigned simd_non_ascii(simd_block block){
+                        return static_cast<unsigned>(_mm256_movemask_epi8(block));
+                }
+                #elif defined(CSV_IO_SIMD_SSE2)
+                typedef __m128i simd_block;
+                const int simd_width = 16;
+
+                inline simd_block simd_load(const char*p){
+                        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                }
+
+                inline simd_block simd_splat(char c){
+                        return _mm_set1_epi8(c);
+                }
+
+                inline unsigned simd_equal(simd_block block, simd_block c){
+                        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, c)));
+                }
+
+                inline unsigned simd_non_ascii(simd_block block){
+                        return static_cast<unsigned>(_mm_movemask_epi8(block));
+                }
+                #endif
+
+                inline int first_bit(unsigned mask){
+                        assert(mask != 0);
+                        #if defined(__GNUC__)
+                        return __builtin_ctz(mask);
+                        #else
+                        int i = 0;
+                        while((mask & 1u) == 0){
+                                mask >>= 1;
+                                ++i;
+                        }
+                        return i;
+                        #endif
+                }
+
+                // Returns the first a or b in [begin, end) or end.
+                template<char a, char b>
+                const char*find_first_of(const char*begin, const char*end){
+                        #ifdef CSV_IO_SIMD
+                        const simd_block block_a = simd_splat(a);
+                        const simd_block block_b = simd_splat(b);
+                        for(; end - begin >= simd_width; begin += simd_width){
+                                simd_block block = simd_load(begin);
+                                unsigned found = simd_equal(block, block_a) | simd_equal(block, block_b);
+                                if(found != 0)
+                                        return begin + first_bit(found);
+                        }
+                        #endif
+                        while(begin != end && *begin != a && *begin != b)
+                                ++begin;
+                        return begin;
+                }
+
+                // Returns whether [begin, end) is well-formed UTF-8: no overlong encodings,
+                // surrogates or code points above U+10FFFF. Blocks of ASCII are skipped
+                // at once.
+                inline bool is_valid_utf8(const char*begin, const char*end){
+                        const unsigned char*p = reinterpret_cast<const unsigned char*>(begin);
+                        const unsigned char*e = reinterpret_cast<const unsigned char*>(end);
+                        while(p != e){
+                                unsigned char c = *p;
+                                if(c < 0x80){
+                                        #ifdef CSV_IO_SIMD
+                                        if(e - p >= simd_width && simd_non_ascii(simd_load(reinterpret_cast<const char*>(p))) == 0){
+                                                p += simd_width;
+                                                continue;
+                                        }
+                                        #endif
+                                        ++p;
+                                        continue;
+                                }
+                                int length;
+                                unsigned char min_next = 0x80, max_next = 0xBF;
+                                if(c >= 0xC2 && c <= 0xDF){
+                                        length = 2;
+                                }else if(c >= 0xE0 && c <= 0xEF){
+                                        length = 3;
+                                        if(c == 0xE0)
+                                                min_next = 0xA0;
+                                        else if(c == 0xED)
+                                                max_next = 0x9F;
+                                }else if(c >= 0xF0 && c <= 0xF4){
+                                        length = 4;
+                                        if(c == 0xF0)
+                                                min_next = 0x90;
+                                        else if(c == 0xF4)
+                                                max_next = 0x8F;
+                                }else{
+                                        return false;
+                                }
+                                if(e - p < length || p[1] < min_next || p[1] > max_next)
+                                        return false;
+                                for(int i=2; i<length; ++i)
+                                        if((p[i] & 0xC0) != 0x80)
+                                                return false;
+                                p += length;
+                        }
+                        return true;
+                }
         }
 
         class LineReader{
         private:
-                static const int block_len = 1<<20;
+                static const int block_len = CSV_IO_BLOCK_LEN;
                 std::unique_ptr<char[]>buffer; // must be constructed before (and thus destructed after) the reader!
                 #ifdef CSV_IO_NO_THREAD
                 detail::SynchronousReader reader;
@@ -347,7 +514,8 @@ namespace io{
                 void init(std::unique_ptr<ByteSourceBase>byte_source){
                         file_line = 0;
 
-                        buffer = std::unique_ptr<char[]>(new char[3*block_len]);
+                        // the last line w/o newline is terminated after data_end
+                        buffer = std::unique_ptr<char[]>(new char[2*block_len+1]);
                         data_begin = 0;
                         data_end = byte_source->read(buffer.get(), 2*block_len);
 
@@ -356,8 +524,7 @@ namespace io{
                                 data_begin = 3;
 
                         if(data_end == 2*block_len){
-                                reader.init(std::move(byte_source));
-                                reader.start_read(buffer.get() + 2*block_len, block_len);
+                                reader.init(std::move(byte_source), block_len);
                         }
                 }
 
@@ -455,16 +622,13 @@ namespace io{
                                 data_begin -= block_len;
                                 data_end -= block_len;
                                 if(reader.is_valid())
-                                {
-                                        data_end += reader.finish_read();
-                                        std::memcpy(buffer.get()+block_len, buffer.get()+2*block_len, block_len);
-                                        reader.start_read(buffer.get() + 2*block_len, block_len);
-                                }
+                                        data_end += reader.read(buffer.get()+block_len);
                         }
 
-                        int line_end = data_begin;
-                        while(buffer[line_end] != '\n' && line_end != data_end){
-                                ++line_end;
+                        int line_end = data_end;
+                        const char*newline = static_cast<const char*>(std::memchr(buffer.get()+data_begin, '\n', data_end-data_begin));
+                        if(newline != nullptr){
+                                line_end = static_cast<int>(newline - buffer.get());
                         }
 
                         if(line_end - data_begin + 1 > block_len){
@@ -474,6 +638,13 @@ namespace io{
                                 throw err;
                         }
 
+                        if(!detail::is_valid_utf8(buffer.get()+data_begin, buffer.get()+line_end)){
+                                error::invalid_utf8 err;
+                                err.set_file_name(file_name);
+                                err.set_file_line(file_line);
+                                throw err;
+                        }
+
                         if(buffer[line_end] == '\n' && line_end != data_end){
                                 buffer[line_end] = '\0';
                         }else{
@@ -491,6 +662,107 @@ namespace io{
                         data_begin = line_end+1;
                         return ret;
                 }
+
+                // Same as next_line() w/ the line returned as [begin, end) view
+                bool next_line(const char*&begin, const char*&end){
+                        char*line = next_line();
+                        if(!line)
+                                return false;
+                        begin = line;
+                        end = line + std::strlen(line);
+                        return true;
+                }
+        };
+
+        // Line reader which returns lines of the caller's read only memory (e.g.
+        // a file mapping) as [begin, end) views - there is no block buffer and
+        // nothing is copied or written to the memory.
+        class ViewLineReader{
+        private:
+                const char*data_begin;
+                const char*data_end;
+
+                char file_name[error::max_file_name_length+1];
+                unsigned file_line;
+
+                void init(const char*begin, const char*end){
+                        file_line = 0;
+                        data_begin = begin;
+                        data_end = end;
+
+                        // Ignore UTF-8 BOM
+                        if(data_end - data_begin >= 3 && data_begin[0] == '\xEF' && data_begin[1] == '\xBB' && data_begin[2] == '\xBF')
+                                data_begin += 3;
+                }
+
+        public:
+                ViewLineReader() = delete;
+                ViewLineReader(const ViewLineReader&) = delete;
+                ViewLineReader&operator=(const ViewLineReader&) = delete;
+
+                ViewLineReader(const char*file_name, const char*data_begin, const char*data_end){
+                        set_file_name(file_name);
+                        init(data_begin, data_end);
+                }
+
+                ViewLineReader(const std::string&file_name, const char*data_begin, const char*data_end){
+                        set_file_name(file_name.c_str());
+                        init(data_begin, data_end);
+                }
+
+                void set_file_name(const std::string&file_name){
+                        set_file_name(file_name.c_str());
+                }
+
+                void set_file_name(const char*file_name){
+                        if(file_name != nullptr){
+                                strncpy(this->file_name, file_name, sizeof(this->file_name));
+                                this->file_name[sizeof(this->file_name)-1] = '\0';
+                        }else{
+                                this->file_name[0] = '\0';
+                        }
+                }
+
+                const char*get_truncated_file_name()const{
+                        return file_name;
+                }
+
+                void set_file_line(unsigned file_line){
+                        this->file_line = file_line;
+                }
+
+                unsigned get_file_line()const{
+                        return file_line;
+                }
+
+                bool next_line(const char*&begin, const char*&end){
+                        if(data_begin == data_end)
+                                return false;
+
+                        ++file_line;
+
+                        const char*line_end = static_cast<const char*>(std::memchr(data_begin, '\n', data_end - data_begin));
+                        if(line_end == nullptr){
+                                // some files are missing the newline at the end of the
+                                // last line
+                                line_end = data_end;
+                        }
+                        if(!detail::is_valid_utf8(data_begin, line_end)){
+                                error::invalid_utf8 err;
+                                err.set_file_name(file_name);
+                                err.set_file_line(file_line);
+                                throw err;
+                        }
+                        begin = data_begin;
+                        end = line_end;
+                        data_begin = line_end != data_end ? line_end+1 : data_end;
+
+                        // handle windows \r\n-line breaks
+                        if(end != begin && *(end-1) == '\r')
+                                --end;
+
+                        return true;
+                }
         };
 
 
@@ -680,11 +952,6 @@ namespace io{
                 };
         }
 
-        using ignore_column = unsigned int;
-        static const ignore_column ignore_no_column = 0;
-        static const ignore_column ignore_extra_column = 1;
-        static const ignore_column ignore_missing_column = 2;
-
         template<char ... trim_char_list>
         struct trim_chars{
         private:
@@ -705,53 +972,16 @@ namespace io{
                                 --str_end;
                         *str_end = '\0';
                 }
-        };
-
-
-        struct no_comment{
-                static bool is_comment(const char*){
-                        return false;
-                }
-        };
 
-        template<char ... comment_start_char_list>
-        struct single_line_comment{
-        private:
-                constexpr static bool is_comment_start_char(char){
-                        return false;
-                }
-       
-                template<class ...OtherCommentStartChars>
-                constexpr static bool is_comment_start_char(char c, char comment_start_char, OtherCommentStartChars...other_comment_start_chars){
-                        return c == comment_start_char || is_comment_start_char(c, other_comment_start_chars...);
-                }
-
-        public:
-
-                static bool is_comment(const char*line){
-                        return is_comment_start_char(*line, comment_start_char_list...);
-                }
-        };
-
-        struct empty_line_comment{
-                static bool is_comment(const char*line){
-                        if(*line == '\0')
-                                return true;
-                        while(*line == ' ' || *line == '\t'){
-                                ++line;
-                                if(*line == 0)
-                                        return true;
-                        }
-                        return false;
+                // view is trimmed w/o writing the terminator
+                static void trim(const char*&str_begin, const char*&str_end){
+                        while(str_begin != str_end && is_trim_char(*str_begin, trim_char_list...))
+                                ++str_begin;
+                        while(str_begin != str_end && is_trim_char(*(str_end-1), trim_char_list...))
+                                --str_end;
                 }
         };
 
-        template<char ... comment_start_char_list>
-        struct single_and_empty_line_comment{
-                static bool is_comment(const char*line){
-                        return single_line_comment<comment_start_char_list...>::is_comment(line) || empty_line_comment::is_comment(line);
-                }
-        };
 
         template<char sep>
         struct no_quote_escape{
@@ -764,6 +994,17 @@ namespace io{
                 static void unescape(char*&, char*&){
 
                 }
+
+                // Returns the end of the column which starts at col_begin in the line
+                // view - the separator or line_end.
+                static const char*find_next_column_end(const char*col_begin, const char*line_end){
+                        const char*col_end = static_cast<const char*>(std::memchr(col_begin, sep, line_end - col_begin));
+                        return col_end ? col_end : line_end;
+                }
+
+                static void unescape(const char*&, const char*&, std::string&){
+
+                }
         };
 
         template<char sep, char quote>
@@ -805,6 +1046,41 @@ namespace io{
                         }
                        
                 }
+
+                // Returns the end of the column which starts at col_begin in the line
+                // view - the separator or line_end.
+                static const char*find_next_column_end(const char*col_begin, const char*line_end){
+                        for(;;){
+                                col_begin = detail::find_first_of<sep, quote>(col_begin, line_end);
+                                if(col_begin == line_end || *col_begin == sep)
+                                        return col_begin;
+                                // quoted up to the closing quote - "" is quoted again
+                                col_begin = static_cast<const char*>(std::memchr(col_begin+1, quote, line_end - (col_begin+1)));
+                                if(col_begin == nullptr)
+                                        throw error::escaped_string_not_closed();
+                                ++col_begin;
+                        }
+                }
+
+                // View is unquoted w/o writing to it: escaped quotes are unescaped
+                // to the buffer and the view is moved there.
+                static void unescape(const char*&col_begin, const char*&col_end, std::string&buffer){
+                        if(col_end - col_begin >= 2 && *col_begin == quote && *(col_end-1) == quote){
+                                ++col_begin;
+                                --col_end;
+                                const char*escaped = static_cast<const char*>(std::memchr(col_begin, quote, col_end - col_begin));
+                                if(escaped == nullptr)
+                                        return;
+                                buffer.assign(col_begin, escaped);
+                                for(const char*in = escaped; in != col_end; ++in){
+                                        if(*in == quote && (in+1) != col_end && *(in+1) == quote)
+                                                ++in;
+                                        buffer.push_back(*in);
+                                }
+                                col_begin = buffer.data();
+                                col_end = buffer.data() + buffer.size();
+                        }
+                }
         };
 
         struct throw_on_overflow{
@@ -859,80 +1135,6 @@ namespace io{
                         }
                 }
 
-                template<class trim_policy, class quote_policy>
-                void parse_line(
-                        char*line,
-                        char**sorted_col,
-                        const std::vector<int>&col_order
-                ){
-                        for (int i : col_order) {
-                                if(line == nullptr)
-                                        throw ::io::error::too_few_columns();
-                                char*col_begin, *col_end;
-                                chop_next_column<quote_policy>(line, col_begin, col_end);
-
-                                if (i != -1) {
-                                        trim_policy::trim(col_begin, col_end);
-                                        quote_policy::unescape(col_begin, col_end);
-                                                               
-                                        sorted_col[i] = col_begin;
-                                }
-                        }
-                        if(line != nullptr)
-                                throw ::io::error::too_many_columns();
-                }
-
-                template<unsigned column_count, class trim_policy, class quote_policy>
-                void parse_header_line(
-                        char*line,
-                        std::vector<int>&col_order,
-                        const std::string*col_name,
-                        ignore_column ignore_policy
-                ){
-                        col_order.clear();
-
-                        bool found[column_count];
-                        std::fill(found, found + column_count, false);
-                        while(line){
-                                char*col_begin,*col_end;
-                                chop_next_column<quote_policy>(line, col_begin, col_end);
-
-                                trim_policy::trim(col_begin, col_end);
-                                quote_policy::unescape(col_begin, col_end);
-                               
-                                for(unsigned i=0; i<column_count; ++i)
-                                        if(col_begin == col_name[i]){
-                                                if(found[i]){
-                                                        error::duplicated_column_in_header err;
-                                                        err.set_column_name(col_begin);
-                                                        throw err;
-                                                }
-                                                found[i] = true;
-                                                col_order.push_back(i);
-                                                col_begin = 0;
-                                                break;
-                                        }
-                                if(col_begin){
-                                        if(ignore_policy & ::io::ignore_extra_column)
-                                                col_order.push_back(-1);
-                                        else{
-                                                error::extra_column_in_header err;
-                                                err.set_column_name(col_begin);
-                                                throw err;
-                                        }
-                                }
-                        }
-                        if(!(ignore_policy & ::io::ignore_missing_column)){
-                                for(unsigned i=0; i<column_count; ++i){
-                                        if(!found[i]){
-                                                error::missing_column_in_header err;
-                                                err.set_column_name(col_name[i].c_str());
-                                                throw err;
-                                        }
-                                }
-                        }
-                }
-
                 template<class overflow_policy>
                 void parse(char*col, char &x){
                         if(!*col)
@@ -1021,8 +1223,10 @@ namespace io{
                 template<class overflow_policy>void parse(char*col, signed long long &x)
                         {parse_signed_integer<overflow_policy>(col, x);}
 
+                // Digit by digit accumulation in T: inexact, but it accepts a decimal
+                // comma as well.
                 template<class T>
-                void parse_float(const char*col, T&x){
+                void parse_float_by_digits(const char*col, T&x){
                         bool is_neg = false;
                         if(*col == '-'){
                                 is_neg = true;
@@ -1084,6 +1288,80 @@ namespace io{
                                 x = -x;
                 }
 
+                // Returns the largest k such that 10^k is exact in T (5^k < 2^digits).
+                template<class T>
+                constexpr int max_exact_power_of_ten(){
+                        int k = 0;
+                        std::uint64_t power_of_five = 1;
+                        while(k < 19 && power_of_five*5 < (std::uint64_t{1} << std::numeric_limits<T>::digits)){
+                                power_of_five *= 5;
+                                ++k;
+                        }
+                        return k;
+                }
+
+                // Correctly rounded so that the shortest text of a value reads back
+                // to the same value. Plain decimals w/ mantissa and power of ten exact
+                // in T are divided once (Clinger's fast path), others are parsed by
+                // std::from_chars(). Empty column, leading '+', decimal comma and out
+                // of range values are parsed by digits.
+                template<class T>
+                void parse_float(const char*col, T&x){
+                        const char*digits = col + (*col == '-' ? 1 : 0);
+                        if constexpr(std::numeric_limits<T>::digits <= 53){
+                                static const std::uint64_t powers_of_ten[] = {
+                                        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+                                        10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+                                        100000000000ull, 1000000000000ull, 10000000000000ull,
+                                        100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+                                        100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+                                };
+                                const char*c = digits;
+                                std::uint64_t mantissa = 0;
+                                int digit_count = 0, fraction_digit_count = 0;
+                                for(; '0' <= *c && *c <= '9' && digit_count < 19; ++c, ++digit_count)
+                                        mantissa = mantissa*10 + (*c - '0');
+                                if(*c == '.'){
+                                        ++c;
+                                        for(; '0' <= *c && *c <= '9' && digit_count < 19; ++c, ++digit_count, ++fraction_digit_count)
+                                                mantissa = mantissa*10 + (*c - '0');
+                                }
+                                if(*c == '\0' && digit_count != 0){
+                                        if(mantissa < (std::uint64_t{1} << std::numeric_limits<T>::digits)
+                                                && fraction_digit_count <= max_exact_power_of_ten<T>())
+                                        {
+                                                x = static_cast<T>(mantissa) / static_cast<T>(powers_of_ten[fraction_digit_count]);
+                                                if(col != digits)
+                                                        x = -x;
+                                                return;
+                                        }
+                                        if constexpr(std::is_same<T, float>::value){
+                                                // long float mantissa (Concept2 speeds) is divided in double and
+                                                // rounded to float unless the double is next to a midpoint
+                                                // of two floats (where the second rounding might differ)
+                                                if(mantissa < (std::uint64_t{1} << 53)){
+                                                        double y = static_cast<double>(mantissa) / static_cast<double>(powers_of_ten[fraction_digit_count]);
+                                                        std::uint64_t bits;
+                                                        std::memcpy(&bits, &y, sizeof(bits));
+                                                        const std::uint64_t below_float = bits & ((std::uint64_t{1} << 29) - 1);
+                                                        const std::uint64_t midpoint = std::uint64_t{1} << 28;
+                                                        if(below_float + 1 - midpoint > 2){
+                                                                x = static_cast<float>(col != digits ? -y : y);
+                                                                return;
+                                                        }
+                                                }
+                                        }
+                                }
+                        }
+                        if(('0' <= *digits && *digits <= '9') || *digits == '.'){
+                                const char*end = digits + std::strlen(digits);
+                                std::from_chars_result result = std::from_chars(col, end, x);
+                                if(result.ec == std::errc() && result.ptr == end)
+                                        return;
+                        }
+                        parse_float_by_digits(col, x);
+                }
+
                 template<class overflow_policy> void parse(char*col, float&x) { parse_float(col, x); }
                 template<class overflow_policy> void parse(char*col, double&x) { parse_float(col, x); }
                 template<class overflow_policy> void parse(char*col, long double&x) { parse_float(col, x); }
@@ -1101,168 +1379,6 @@ namespace io{
                 }
 
         }
-
-        template<unsigned column_count,
-                class trim_policy = trim_chars<' ', '\t'>,
-                class quote_policy = no_quote_escape<','>,
-                class overflow_policy = throw_on_overflow,
-                class comment_policy = no_comment
-        >
-        class CSVReader{
-        private:
-                LineReader in;
-
-                char*row[column_count];
-                std::string column_names[column_count];
-
-                std::vector<int>col_order;
-
-                template<class ...ColNames>
-                void set_column_names(std::string s, ColNames...cols){
-                        column_names[column_count-sizeof...(ColNames)-1] = std::move(s);
-                        set_column_names(std::forward<ColNames>(cols)...);
-                }
-
-                void set_column_names(){}
-
-
-        public:
-                CSVReader() = delete;
-                CSVReader(const CSVReader&) = delete;
-                CSVReader&operator=(const CSVReader&);
-
-                template<class ...Args>
-                explicit CSVReader(Args&&...args):in(std::forward<Args>(args)...){
-                        std::fill(row, row+column_count, nullptr);
-                        col_order.resize(column_count);
-                        for(unsigned i=0; i<column_count; ++i)
-                                col_order[i] = i;
-                        for(unsigned i=1; i<=column_count; ++i)
-                                column_names[i-1] = "col"+std::to_string(i);
-                }
-
-		char*next_line(){
-			return in.next_line();
-		}
-
-                template<class ...ColNames>
-                void read_header(ignore_column ignore_policy, ColNames...cols){
-                        static_assert(sizeof...(ColNames)>=column_count, "not enough column names specified");
-                        static_assert(sizeof...(ColNames)<=column_count, "too many column names specified");
-                        try{
-                                set_column_names(std::forward<ColNames>(cols)...);
-
-                                char*line;
-                                do{
-                                        line = in.next_line();
-                                        if(!line)
-                                                throw error::header_missing();
-                                }while(comment_policy::is_comment(line));
-
-                                detail::parse_header_line
-                                        <column_count, trim_policy, quote_policy>
-                                        (line, col_order, column_names, ignore_policy);
-                        }catch(error::with_file_name&err){
-                                err.set_file_name(in.get_truncated_file_name());
-                                throw;
-                        }
-                }
-
-                template<class ...ColNames>
-                void set_header(ColNames...cols){
-                        static_assert(sizeof...(ColNames)>=column_count,
-                                "not enough column names specified");
-                        static_assert(sizeof...(ColNames)<=column_count,
-                                "too many column names specified");
-                        set_column_names(std::forward<ColNames>(cols)...);
-                        std::fill(row, row+column_count, nullptr);
-                        col_order.resize(column_count);
-                        for(unsigned i=0; i<column_count; ++i)
-                                col_order[i] = i;
-                }
-
-                bool has_column(const std::string&name) const {
-                        return col_order.end() != std::find(
-                                col_order.begin(), col_order.end(),
-                                        std::find(std::begin(column_names), std::end(column_names), name)
-                                - std::begin(column_names));
-                }
-
-                void set_file_name(const std::string&file_name){
-                        in.set_file_name(file_name);
-                }
-
-                void set_file_name(const char*file_name){
-                        in.set_file_name(file_name);
-                }
-
-                const char*get_truncated_file_name()const{
-                        return in.get_truncated_file_name();
-                }
-
-                void set_file_line(unsigned file_line){
-                        in.set_file_line(file_line);
-                }
-
-                unsigned get_file_line()const{
-                        return in.get_file_line();
-                }
-
-        private:
-                void parse_helper(std::size_t){}
-
-                template<class T, class ...ColType>
-                void parse_helper(std::size_t r, T&t, ColType&...cols){                        
-                        if(row[r]){
-                                try{
-                                        try{
-                                                ::io::detail::parse<overflow_policy>(row[r], t);
-                                        }catch(error::with_column_content&err){
-                                                err.set_column_content(row[r]);
-                                                throw;
-                                        }
-                                }catch(error::with_column_name&err){
-                                        err.set_column_name(column_names[r].c_str());
-                                        throw;
-                                }
-                        }
-                        parse_helper(r+1, cols...);
-                }
-
-       
-        public:
-                template<class ...ColType>
-                bool read_row(ColType& ...cols){
-                        static_assert(sizeof...(ColType)>=column_count,
-                                "not enough columns specified");
-                        static_assert(sizeof...(ColType)<=column_count,
-                                "too many columns specified");
-                        try{
-                                try{
-       
-                                        char*line;
-                                        do{
-                                                line = in.next_line();
-                                                if(!line)
-                                                        return false;
-                                        }while(comment_policy::is_comment(line));
-                                       
-                                        detail::parse_line<trim_policy, quote_policy>
-                                                (line, row, col_order);
-               
-                                        parse_helper(0, cols...);
-                                }catch(error::with_file_name&err){
-                                        err.set_file_name(in.get_truncated_file_name());
-                                        throw;
-                                }
-                        }catch(error::with_file_line&err){
-                                err.set_file_line(in.get_file_line());
-                                throw;
-                        }
-
-                        return true;
-                }
-        };
 }
 #endif
 
@@ -18,12 +18,23 @@
 */
 #include "dataset.h"
 
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+
 
 namespace etl76 {
 
 using namespace std;
 
 Dataset::Dataset()
+    : readOnly(false),
+      compacting(false),
+      compactionOffset(DatasetJournal::NO_OFFSET),
+      observers(),
+      dateIndex()
 {
 }
 
@@ -34,15 +45,88 @@ Dataset::~Dataset()
 
 void Dataset::clear()
 {
-    for(DatasetInstance* i:dataset) {
-        delete i;
+    // journal belongs to the loaded file
+    journal.close();
+    // instances are views to columns - the pool frees them all at once
+    instancePool.clear();
+    dataset.clear();
+    columns.clear();
+    dateIndex.clear();
+}
+
+void Dataset::createInstances()
+{
+    dataset.reserve(columns.size());
+    for(size_t row=dataset.size(); row<columns.size(); row++) {
+        dataset.push_back(instancePool.create(&columns, row));
+    }
+    dateIndex.build(columns, dataset);
+}
+
+void Dataset::renumberInstances(size_t from)
+{
+    for(size_t row=from; row<dataset.size(); row++) {
+        dataset[row]->setRow(row);
     }
 }
 
+void Dataset::insertRow(size_t index, const DatasetColumns& src, size_t srcRow)
+{
+    columns.insertRow(index, src, srcRow);
+    dataset.insert(dataset.begin()+index, instancePool.create(&columns, index));
+    renumberInstances(index+1);
+    dateIndex.insertRow(columns, index, dataset[index]);
+}
+
+void Dataset::setRow(size_t index, const DatasetColumns& src, size_t srcRow)
+{
+    columns.setRow(index, src, srcRow);
+    dateIndex.setRow(columns, index, dataset[index]);
+}
+
+void Dataset::journalRow(DatasetJournal::Operation operation, size_t index)
+{
+    if(journal.isOpen()) {
+        journal.append(operation, index, dataset[index]->toCsv());
+    }
+}
+
+void Dataset::addInstance(DatasetInstance* instance)
+{
+    insertRow(columns.size(), *instance->getColumns(), instance->getRow());
+    delete instance;
+    notifyInserted(dataset.size()-1);
+    journalRow(DatasetJournal::Operation::INSERT, dataset.size()-1);
+}
+
+void Dataset::insertInstance(DatasetInstance* instance)
+{
+    size_t index = instance->getDatasetIndex();
+    insertRow(index, *instance->getColumns(), instance->getRow());
+    delete instance;
+    notifyInserted(index);
+    journalRow(DatasetJournal::Operation::INSERT, index);
+}
+
+void Dataset::setInstance(int index, DatasetInstance* instance)
+{
+    // existing view of the row stays valid
+    notifyRemoved(index);
+    setRow(index, *instance->getColumns(), instance->getRow());
+    delete instance;
+    notifyInserted(index);
+    journalRow(DatasetJournal::Operation::SET, index);
+}
+
 int Dataset::removeInstance(int index) {
     if(index >=0 && static_cast<size_t>(index) < dataset.size()) {
-        delete dataset[index];
+        notifyRemoved(index);
+        dateIndex.eraseRow(index, dataset[index]);
+        columns.eraseRow(index);
+        instancePool.destroy(dataset[index]);
         dataset.erase(dataset.begin()+index);
+        renumberInstances(index);
+        journal.append(DatasetJournal::Operation::REMOVE, index);
         return min(static_cast<size_t>(index), dataset.size());
     } else {
         throw EtlRuntimeException(
@@ -53,9 +137,14 @@ int Dataset::removeInstance(int index) {
 
 void Dataset::switchInstances(int a, int b)
 {
+    columns.swapRows(a, b);
     DatasetInstance* x = dataset[a];
     dataset[a] = dataset[b];
     dataset[b] = x;
+    dataset[a]->setRow(a);
+    dataset[b]->setRow(b);
+    dateIndex.swapRows(a, dataset[a], b, dataset[b]);
+    journal.append(DatasetJournal::Operation::SWITCH, a, b);
 }
 
 int Dataset::upInstance(int index)
@@ -82,251 +171,364 @@ int Dataset::downInstance(int index)
     return -1;
 }
 
-void Dataset::from_csv(const string& file_path)
+/*
+ * CSV
+ */
+
+static const char* CSV_HEADER =
+    "year, "
+    "month, "
+    "day, "
+    "when, "
+    "phase, "
+    "activity, "
+    "description, "
+    "commute, "
+    "total_time_seconds, "
+    "total_distance_meters, "
+    "warm_up_time_seconds, "
+    "warm_up_distance_meters, "
+    "time_seconds, "
+    "distance_meters, "
+    "intensity, "
+    "squats, "
+    "push_ups, "
+    "crunches, "
+    "turtles, "
+    "calfs, "
+    "repetitions, "
+    "avg_speed, "
+    "max_speed, "
+    "elevation_gain, "
+    "avg_watts, "
+    "max_watts, "
+    "gear, "
+    "route, "
+    "url, "
+    "kcal, "
+    "cool_down_time_seconds, "
+    "cool_down_distance_meters, "
+    "weight, "
+    "weather, "
+    "weather_temperature, "
+    "where, "
+    "bmi, "
+    "grams_of_fat_burnt, "
+    "source\n";
+
+/**
+ * @brief Chunk of complete CSV records.
+ */
+struct CsvChunk
+{
+    const char* begin;
+    const char* end;
+    // number of file lines before the chunk (error reporting)
+    unsigned lineOffset;
+};
+
+/*
+ * Split records to roughly equal chunks. A newline is a record boundary only
+ * outside of a quoted field so that a record w/ quoted description is never
+ * split between two chunks.
+ */
+static vector<CsvChunk> splitCsvRecords(const char* begin, const char* end, unsigned lineOffset, size_t chunkCount)
+{
+    vector<CsvChunk> chunks{};
+    chunks.reserve(chunkCount);
+
+    const size_t chunkSize = (end-begin)/chunkCount + 1;
+    const char* chunkBegin = begin;
+    const char* chunkNominalEnd = begin + chunkSize;
+    unsigned chunkLineOffset = lineOffset;
+    unsigned line = lineOffset;
+    bool quoted = false;
+    for(const char* c = begin; ; ++c) {
+        c = io::detail::find_first_of<'"', '\n'>(c, end);
+        if(c == end) {
+            break;
+        }
+        if(*c == '"') {
+            // escaped "" toggles twice
+            quoted = !quoted;
+        } else if(*c == '\n') {
+            ++line;
+            if(!quoted && c+1 >= chunkNominalEnd && c+1 != end) {
+                chunks.push_back(CsvChunk{chunkBegin, c+1, chunkLineOffset});
+                chunkBegin = c+1;
+                chunkNominalEnd = chunkBegin + chunkSize;
+                chunkLineOffset = line;
+            }
+        }
+    }
+    if(chunkBegin != end) {
+        chunks.push_back(CsvChunk{chunkBegin, end, chunkLineOffset});
+    }
+
+    return chunks;
+}
+
+static void readCsvChunk(
+        const string& file_path,
+        const CsvChunk& chunk,
+        const DatasetCsvReader& header,
+        DatasetColumns& batch)
+{
+    io::ViewLineReader in(file_path, chunk.begin, chunk.end);
+    in.set_file_line(chunk.lineOffset);
+    DatasetCsvReader reader{};
+    reader.setHeader(header);
+    reader.readRows(in, batch);
+}
+
+void Dataset::from_csv_parallel(const string& file_path)
+{
+    // read only mapping is shared by workers - each parses its own chunk
+    MappedFile csvFile{file_path};
+
+    const char* bodyBegin = static_cast<const char*>(memchr(csvFile.begin(), '\n', csvFile.getSize()));
+    bodyBegin = bodyBegin ? bodyBegin+1 : csvFile.end();
+    io::ViewLineReader headerLine(file_path, csvFile.begin(), bodyBegin);
+    DatasetCsvReader header{};
+    header.readHeader(headerLine);
+
+    size_t chunkCount = max(1u, thread::hardware_concurrency());
+    chunkCount = max(
+        static_cast<size_t>(1),
+        min(chunkCount, static_cast<size_t>(csvFile.end()-bodyBegin)/PARALLEL_CSV_MIN_CHUNK_SIZE));
+    vector<CsvChunk> chunks = splitCsvRecords(bodyBegin, csvFile.end(), 1, chunkCount);
+
+    // 1st chunk is parsed by the calling thread directly to dataset columns
+    vector<unique_ptr<DatasetColumns>> batches{};
+    for(size_t i=1; i<chunks.size(); i++) {
+        batches.push_back(unique_ptr<DatasetColumns>(new DatasetColumns{}));
+    }
+    vector<exception_ptr> errors(chunks.size());
+    vector<thread> workers{};
+    for(size_t i=1; i<chunks.size(); i++) {
+        workers.push_back(thread([&, i] {
+            try {
+                readCsvChunk(file_path, chunks[i], header, *batches[i-1]);
+            } catch(...) {
+                errors[i] = current_exception();
+            }
+        }));
+    }
+    if(chunks.size()) {
+        try {
+            readCsvChunk(file_path, chunks[0], header, columns);
+        } catch(...) {
+            errors[0] = current_exception();
+        }
+    }
+    for(thread& worker:workers) {
+        worker.join();
+    }
+
+    // report the first error in file order, join batches in file order
+    for(exception_ptr& error:errors) {
+        if(error) {
+            columns.clear();
+            rethrow_exception(error);
+        }
+    }
+    size_t size = columns.size();
+    for(unique_ptr<DatasetColumns>& batch:batches) {
+        size += batch->size();
+    }
+    columns.reserve(size);
+    for(unique_ptr<DatasetColumns>& batch:batches) {
+        columns.spliceRows(*batch);
+    }
+}
+
+void Dataset::from_csv(const string& file_path, CsvLoadMode mode)
 {
     clear();
 
-    io::CSVReader<39, io::trim_chars<' '>, io::double_quote_escape<',','\"'>> in(file_path);
-    in.read_header(
-        io::ignore_extra_column,
-        "year",
-        "month",
-        "day",
-        "when",
-        "phase",
-        "activity",
-        "description",
-        "commute",
-        "total_time_seconds",
-        "total_distance_meters",
-        "warm_up_time_seconds",
-        "warm_up_distance_meters",
-        "time_seconds",
-        "distance_meters",
-        "intensity",
-        "squats",
-        "push_ups",
-        "crunches",
-        "turtles",
-        "calfs",
-        "repetitions",
-        "avg_speed",
-        "max_speed",
-        "elevation_gain",
-        "avg_watts",
-        "max_watts",
-        "gear",
-        "route",
-        "url",
-        "kcal",
-        "cool_down_time_seconds",
-        "cool_down_distance_meters",
-        "weight",
-        "weather",
-        "weather_temperature",
-        "where",
-        "bmi",
-        "grams_of_fat_burnt",
-        "source"
-    );
-
-    unsigned year;
-    unsigned month;
-    unsigned day;
-    string when;
-    unsigned phase;
-    string activity;
-    string description;
-    unsigned commute;
-    unsigned totalTimeSeconds;
-    unsigned totalDistanceMeters;
-    unsigned warmUpTimeSeconds;
-    unsigned warmUpDistanceMeters;
-    unsigned timeSeconds;
-    unsigned distanceMeters;
-    string intensity;
-    unsigned squats;
-    unsigned pushUps;
-    unsigned crunches;
-    unsigned turtles;
-    unsigned calfs;
-    unsigned repetitions;
-    float avgSpeed;
-    float maxSpeed;
-    unsigned elevationGain;
-    unsigned avgWatts;
-    unsigned maxWatts;
-    string gear;
-    string route;
-    string url;
-    unsigned kcal;
-    unsigned coolDownTimeSeconds;
-    unsigned coolDownDistanceMeters;
-    float weight;
-    string weather;
-    unsigned weatherTemperature;
-    string where;
-    float bmi;
-    unsigned gramsOfFatBurnt;
-    string source;
-
-    DatasetInstance* instance;
-
-    while(in.read_row(
-      year,
-      month,
-      day,
-      when,
-      phase,
-      activity,
-      description,
-      commute,
-      totalTimeSeconds,
-      totalDistanceMeters,
-      warmUpTimeSeconds,
-      warmUpDistanceMeters,
-      timeSeconds,
-      distanceMeters,
-      intensity,
-      squats,
-      pushUps,
-      crunches,
-      turtles,
-      calfs,
-      repetitions,
-      avgSpeed,
-      maxSpeed,
-      elevationGain,
-      avgWatts,
-      maxWatts,
-      gear,
-      route,
-      url,
-      kcal,
-      coolDownTimeSeconds,
-      coolDownDistanceMeters,
-      weight,
-      weather,
-      weatherTemperature,
-      where,
-      bmi,
-      gramsOfFatBurnt,
-      source)
-    ) {
-        instance = new DatasetInstance{
-            year,
-            month,
-            day,
-            QString::fromStdString(when),
-            phase,
-            CategoricalValue{activity},
-            QString::fromStdString(description),
-            commute!=0,
-            totalTimeSeconds,
-            totalDistanceMeters,
-            warmUpTimeSeconds,
-            warmUpDistanceMeters,
-            timeSeconds,
-            distanceMeters,
-            CategoricalValue{intensity},
-            squats,
-            pushUps,
-            crunches,
-            turtles,
-            calfs,
-            repetitions,
-            avgSpeed,
-            maxSpeed,
-            elevationGain,
-            avgWatts,
-            maxWatts,
-            CategoricalValue{gear},
-            CategoricalValue{route},
-            QString::fromStdString(url),
-            kcal,
-            coolDownTimeSeconds,
-            coolDownDistanceMeters,
-            weight,
-            CategoricalValue{weather},
-            weatherTemperature,
-            QString::fromStdString(where),
-            bmi,
-            gramsOfFatBurnt,
-            CategoricalValue{source}
-         };
-        addInstance(instance);
+    // rows parsed before an error must not be saved over the file
+    readOnly = true;
+    try {
+        if(mode == CsvLoadMode::PARALLEL) {
+            from_csv_parallel(file_path);
+        } else if(mode == CsvLoadMode::MAPPED) {
+            // read only mapping is parsed by views: no read() copies to the block buffer
+            MappedFile csvFile{file_path};
+            io::ViewLineReader in(file_path, csvFile.begin(), csvFile.end());
+            DatasetCsvReader reader{};
+            reader.readHeader(in);
+            reader.readRows(in, columns);
+        } else {
+            io::LineReader in(file_path);
+            DatasetCsvReader reader{};
+            reader.readHeader(in);
+            reader.readRows(in, columns);
+        }
+    } catch(...) {
+        clear();
+        throw;
     }
+    readOnly = false;
+
+    createInstances();
 }
 
-bool Dataset::file_exists(const std::string& file_path)
+/*
+ * Journal
+ */
+
+void Dataset::open_journal(const string& file_path)
 {
-  struct stat buffer;
-  return (stat(file_path.c_str(), &buffer) == 0);
+    if(readOnly) {
+        // edits of a dataset which was not loaded are not journaled
+        return;
+    }
+
+    // rows of journal records are parsed as CSV w/ dataset header
+    vector<DatasetJournal::Record> records{};
+    string rowsCsv{CSV_HEADER};
+    size_t validSize = DatasetJournal::read(file_path, records, rowsCsv);
+
+    size_t replayed = 0;
+    if(records.size()) {
+        // rows are parsed one by one: record of the first invalid row is out of range below
+        DatasetColumns rows{};
+        try {
+            io::ViewLineReader in(DatasetJournal::journalPath(file_path), rowsCsv.data(), rowsCsv.data()+rowsCsv.size());
+            DatasetCsvReader reader{};
+            reader.readHeader(in);
+            const char* begin;
+            const char* end;
+            try {
+                while(in.next_line(begin, end)) {
+                    reader.parseRow(begin, end, rows);
+                }
+            } catch(io::error::with_file_name& e) {
+                e.set_file_name(in.get_truncated_file_name());
+                throw;
+            }
+        } catch(exception& e) {
+            cerr << "Journal row " << rows.size() << " cannot be parsed: " << e.what() << endl;
+        }
+
+        for(DatasetJournal::Record& record:records) {
+            bool valid = true;
+            switch(record.operation) {
+            case DatasetJournal::Operation::INSERT:
+                if((valid = record.index <= dataset.size() && record.argument < rows.size())) {
+                    insertRow(record.index, rows, record.argument);
+                }
+                break;
+            case DatasetJournal::Operation::SET:
+                if((valid = record.index < dataset.size() && record.argument < rows.size())) {
+                    setRow(record.index, rows, record.argument);
+                }
+                break;
+            case DatasetJournal::Operation::REMOVE:
+                if((valid = record.index < dataset.size())) {
+                    removeInstance(record.index);
+                }
+                break;
+            case DatasetJournal::Operation::SWITCH:
+                if((valid = record.index < dataset.size() && record.argument < dataset.size())) {
+                    switchInstances(record.index, record.argument);
+                }
+                break;
+            case DatasetJournal::Operation::COMPACTION:
+                // markers are not returned as records
+                break;
+            }
+            if(!valid) {
+                cerr << "Journal record out of dataset range or w/ invalid row - journal is replayed up to it" << endl;
+                validSize = replayed ? records[replayed-1].end : 0;
+                break;
+            }
+            replayed++;
+        }
+    }
+
+    journal.open(file_path, validSize, replayed);
 }
 
-void Dataset::to_csv(const std::string& file_path) const
+bool Dataset::commit(const string& file_path, DatasetSaver::Callback done)
+{
+    if(readOnly || compacting
+           || (journal.isOpen() && journal.size() < DatasetJournal::COMPACTION_RECORDS))
+    {
+        // edits are in the journal (or they will be compacted once running compaction finishes)
+        return false;
+    }
+
+    // immutable copy is saved in background while edits are appended to the journal
+    unique_ptr<DatasetColumns> copy{new DatasetColumns{}};
+    copy->assign(columns);
+    compacting = true;
+    compactionOffset = journal.getEndOffset();
+    saver.saveAsync(std::move(copy), file_path, CSV_HEADER, compactionOffset, done);
+    return true;
+}
+
+void Dataset::finish_compaction(const string& file_path, bool success)
 {
-    if(file_exists(file_path)) {
-        // clean up
-        string tmp_file_path{file_path+".tmp"};
-        if(file_exists(tmp_file_path)) {
-            remove(tmp_file_path.c_str());
+    saver.wait();
+    if(compacting) {
+        compacting = false;
+        if(success) {
+            journal.rebase(file_path, compactionOffset);
         }
-        // if save fails, return back to this file: avoid loosing both old and new
-        rename(file_path.c_str(), (file_path+".tmp").c_str());
     }
+}
+
+void Dataset::compact(const string& file_path)
+{
+    if(readOnly) {
+        throw EtlRuntimeException("Dataset "+file_path+" was not loaded - it is not saved");
+    }
+
+    // background compaction is superseded
+    saver.wait();
+    compacting = false;
+
+    // journal stays open if the CSV cannot be written
+    DatasetSaver::save(
+        columns,
+        file_path,
+        CSV_HEADER,
+        journal.getEndOffset());
+    // new CSV file makes the old journal stale
+    journal.open(file_path, 0, 0);
+}
+
+bool Dataset::from_snapshot(const string& file_path)
+{
+    clear();
 
-    // save
-    std::ofstream csvFile;
-    csvFile.open (file_path);
-
-    csvFile <<
-       "year, "
-       "month, "
-       "day, "
-       "when, "
-       "phase, "
-       "activity, "
-       "description, "
-       "commute, "
-       "total_time_seconds, "
-       "total_distance_meters, "
-       "warm_up_time_seconds, "
-       "warm_up_distance_meters, "
-       "time_seconds, "
-       "distance_meters, "
-       "intensity, "
-       "squats, "
-       "push_ups, "
-       "crunches, "
-       "turtles, "
-       "calfs, "
-       "repetitions, "
-       "avg_speed, "
-       "max_speed, "
-       "elevation_gain, "
-       "avg_watts, "
-       "max_watts, "
-       "gear, "
-       "route, "
-       "url, "
-       "kcal, "
-       "cool_down_time_seconds, "
-       "cool_down_distance_meters, "
-       "weight, "
-       "weather, "
-       "weather_temperature, "
-       "where, "
-       "bmi, "
-       "grams_of_fat_burnt, "
-       "source"
-       << endl;
-
-    for(DatasetInstance* instance:dataset) {
-        csvFile << instance->toCsv();
+    if(!DatasetSnapshot::isFresh(file_path)) {
+        return false;
+    }
+    try {
+        DatasetSnapshot::read(file_path, columns);
+    } catch(EtlRuntimeException& e) {
+        // snapshot is just a cache of the CSV which is parsed instead
+        cerr << e.what() << endl;
+        clear();
+        return false;
     }
 
-    csvFile.close();
+    readOnly = false;
+    createInstances();
+    return true;
+}
+
+bool Dataset::file_exists(const std::string& file_path)
+{
+  struct stat buffer;
+  return (stat(file_path.c_str(), &buffer) == 0);
+}
+
+void Dataset::to_csv(const std::string& file_path) const
+{
+    DatasetSaver::save(columns, file_path, CSV_HEADER, DatasetJournal::NO_OFFSET);
 }
 
 } // etl76 namespace
@@ -19,21 +19,72 @@
 #ifndef ETL76_DATASET_H
 #define ETL76_DATASET_H
 
+#include <algorithm>
 #include <fstream>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <vector>
 
 #include "csv.h"
+#include "dataset_columns.h"
+#include "dataset_csv_reader.h"
+#include "date_index.h"
 #include "dataset_instance.h"
+#include "dataset_instance_pool.h"
+#include "dataset_journal.h"
+#include "dataset_observer.h"
+#include "dataset_saver.h"
+#include "dataset_snapshot.h"
 #include "exceptions.h"
+#include "mapped_file.h"
 
 namespace etl76 {
 
 class Dataset
 {
+public:
+    /**
+     * @brief CSV load mode.
+     */
+    enum class CsvLoadMode {
+        // file is memory mapped, split to chunks of records and chunks
+        // are parsed by parallel workers
+        PARALLEL,
+        // file is memory mapped and parsed w/o copying
+        MAPPED,
+        // file is read by blocks to CSV reader's buffer
+        BUFFERED
+    };
+
+    // chunks smaller than this are not worth a worker thread
+    static const size_t PARALLEL_CSV_MIN_CHUNK_SIZE = 1<<18;
+
 private:
+    DatasetColumns columns;
+    // instances are row views of the columns: I-th instance is view of I-th row
     std::vector<DatasetInstance*> dataset;
+    DatasetInstancePool instancePool;
+    DatasetJournal journal;
+    DatasetSaver saver;
+    // failed load: columns are empty and the file must not be overwritten
+    bool readOnly;
+    // background compaction: journal size when the columns were copied
+    bool compacting;
+    size_t compactionOffset;
+    // notified about edits (not about loads)
+    std::vector<DatasetObserver*> observers;
+    // rows sorted by date
+    DateIndex dateIndex;
+
+    void createInstances();
+    void renumberInstances(size_t from);
+    void insertRow(size_t index, const DatasetColumns& src, size_t srcRow);
+    void setRow(size_t index, const DatasetColumns& src, size_t srcRow);
+    void journalRow(DatasetJournal::Operation operation, size_t index);
+    void notifyInserted(size_t index) { for(DatasetObserver* o:observers) o->onRowInserted(columns, index); }
+    void notifyRemoved(size_t index) { for(DatasetObserver* o:observers) o->onRowRemoved(columns, index); }
+
+    void from_csv_parallel(const std::string& file_path);
 
 public:
     Dataset();
@@ -45,26 +96,89 @@ public:
 
     void clear();
 
-    void addInstance(DatasetInstance* instance) {
-        dataset.push_back(instance);
-    }
-    void insertInstance(DatasetInstance* instance) {
-        dataset.insert(dataset.begin()+instance->getDatasetIndex(), instance);
-    }
-    void setInstance(int index, DatasetInstance* instance) {
-        delete dataset[index];
-        dataset[index]=instance;
-    }
+    /*
+     * Row of given (detached) instance is copied to dataset columns and the
+     * instance is deleted - dataset creates its own view of the row.
+     */
+
+    void addInstance(DatasetInstance* instance);
+    void insertInstance(DatasetInstance* instance);
+    void setInstance(int index, DatasetInstance* instance);
 
     int removeInstance(int index);
     void switchInstances(int a, int b);
     int upInstance(int index);
     int downInstance(int index);
 
+    /**
+     * @brief Add observer of inserted, set and removed instances.
+     */
+    void addObserver(DatasetObserver* observer) { observers.push_back(observer); }
+    void removeObserver(DatasetObserver* observer) {
+        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    }
+
     std::vector<DatasetInstance*>& getInstances() { return dataset; }
+    const DatasetColumns& getColumns() const { return columns; }
+    const DateIndex& getDateIndex() const { return dateIndex; }
+    /**
+     * @brief Bytes held by the dataset: columns and instances.
+     */
+    size_t getByteSize() const {
+        return columns.getByteSize()
+            + instancePool.getByteSize()
+            + dataset.capacity()*sizeof(DatasetInstance*);
+    }
 
-    void from_csv(const std::string& file_path);
+    /**
+     * @brief Load dataset from the CSV file.
+     *
+     * If the file cannot be parsed, the dataset is cleared, read only (edits
+     * are neither journaled nor saved) and the error is rethrown. Successful
+     * load makes it writable again.
+     */
+    void from_csv(const std::string& file_path, CsvLoadMode mode=CsvLoadMode::PARALLEL);
+    bool isReadOnly() const { return readOnly; }
+    /**
+     * @brief Save dataset to CSV and its binary snapshot next to it.
+     *
+     * CSV is replaced atomically. Throws runtime exception if CSV cannot be
+     * written - the previous version of the file is kept.
+     */
     void to_csv(const std::string& file_path) const;
+    /**
+     * @brief Replay journal of the CSV file on top of loaded dataset and open it.
+     *
+     * Edits of the dataset are appended to the open journal.
+     */
+    void open_journal(const std::string& file_path);
+    /**
+     * @brief Persist edits.
+     *
+     * Edits are already appended to the journal (O(1) I/O), dataset is
+     * compacted only if journal is long or it is not open. Compaction
+     * runs in background: returns true if it was started - done is called
+     * from the saver thread and finish_compaction() must be called then
+     * from the editor thread. Read only dataset is never compacted.
+     */
+    bool commit(const std::string& file_path, DatasetSaver::Callback done);
+    void finish_compaction(const std::string& file_path, bool success);
+    bool is_compacting() const { return compacting; }
+    /**
+     * @brief Save dataset to CSV and start new journal in the calling thread.
+     *
+     * to_csv() alone does not touch the journal: use compact() to save
+     * dataset w/ open journal. Throws runtime exception if dataset is read only.
+     */
+    void compact(const std::string& file_path);
+    size_t getJournalSize() const { return journal.size(); }
+    /**
+     * @brief Load dataset from binary snapshot of the CSV file.
+     *
+     * Returns false (and dataset is empty) if snapshot is missing, older
+     * than the CSV or damaged - CSV must be parsed then.
+     */
+    bool from_snapshot(const std::string& file_path);
 
     static bool file_exists(const std::string& file_path);
 };
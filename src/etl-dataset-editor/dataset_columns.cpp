@@ -0,0 +1,298 @@
+/*
+ dataset_columns.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_columns.h"
+
+#include <iterator>
+#include <utility>
+
+namespace etl76 {
+
+using namespace std;
+
+DatasetColumns::DatasetColumns()
+    : rows(0)
+{
+}
+
+template<class Op>
+void DatasetColumns::forEachColumn(Op op)
+{
+    for(vector<unsigned>& column:uintColumns) op(column);
+    for(vector<float>& column:floatColumns) op(column);
+    for(vector<unsigned>& column:categoricalColumns) op(column);
+}
+
+template<class Op>
+void DatasetColumns::forEachColumn(const DatasetColumns& src, Op op)
+{
+    for(int c=0; c<UINT_COLUMN_COUNT; c++) op(uintColumns[c], src.uintColumns[c]);
+    for(int c=0; c<FLOAT_COLUMN_COUNT; c++) op(floatColumns[c], src.floatColumns[c]);
+    // categorical codes are valid only in their own dictionaries - see translateCode()
+}
+
+unsigned DatasetColumns::translateCode(CategoricalColumn c, const DatasetColumns& src, size_t srcRow)
+{
+    unsigned code = src.categoricalColumns[c][srcRow];
+    if(&src == this) {
+        return code;
+    }
+    return features[c].intern(src.features[c].getValue(code));
+}
+
+template<class T>
+static void spliceColumn(vector<T>& column, vector<T>& src)
+{
+    column.insert(column.end(), make_move_iterator(src.begin()), make_move_iterator(src.end()));
+    src.clear();
+}
+
+size_t DatasetColumns::getByteSize() const
+{
+    size_t bytes = 0;
+    for(const vector<unsigned>& column:uintColumns) {
+        bytes += column.capacity()*sizeof(unsigned);
+    }
+    for(const vector<float>& column:floatColumns) {
+        bytes += column.capacity()*sizeof(float);
+    }
+    for(const Utf8Column& column:stringColumns) {
+        bytes += column.getByteSize();
+    }
+    for(const vector<unsigned>& column:categoricalColumns) {
+        bytes += column.capacity()*sizeof(unsigned);
+    }
+    for(const CategoricalFeature& feature:features) {
+        bytes += feature.getByteSize();
+    }
+    return bytes;
+}
+
+void DatasetColumns::reserve(size_t capacity)
+{
+    forEachColumn([capacity](auto& column) { column.reserve(capacity); });
+    for(Utf8Column& column:stringColumns) {
+        column.reserve(capacity);
+    }
+}
+
+void DatasetColumns::clear()
+{
+    forEachColumn([](auto& column) { column.clear(); });
+    for(Utf8Column& column:stringColumns) {
+        column.clear();
+    }
+    for(CategoricalFeature& feature:features) {
+        feature.clear();
+    }
+    rows = 0;
+}
+
+void DatasetColumns::assign(const DatasetColumns& src)
+{
+    forEachColumn(src, [](auto& column, const auto& srcColumn) { column = srcColumn; });
+    for(int c=0; c<STRING_COLUMN_COUNT; c++) {
+        stringColumns[c].assign(src.stringColumns[c]);
+    }
+    for(int c=0; c<CATEGORICAL_COLUMN_COUNT; c++) {
+        categoricalColumns[c] = src.categoricalColumns[c];
+        features[c].assign(src.features[c]);
+    }
+    rows = src.rows;
+}
+
+void DatasetColumns::appendRow(
+        unsigned year,
+        unsigned month,
+        unsigned day,
+        const QString& when,
+        unsigned phase,
+        unsigned activity,
+        const QString& description,
+        bool commute,
+        unsigned totalTimeSeconds,
+        unsigned totalDistanceMeters,
+        unsigned warmUpTimeSeconds,
+        unsigned warmUpDistanceMeters,
+        unsigned timeSeconds,
+        unsigned distanceMeters,
+        unsigned intensity,
+        unsigned squats,
+        unsigned pushUps,
+        unsigned crunches,
+        unsigned turtles,
+        unsigned calfs,
+        unsigned repetitions,
+        float avgSpeed,
+        float maxSpeed,
+        unsigned elevationGain,
+        unsigned avgWatts,
+        unsigned maxWatts,
+        unsigned gear,
+        unsigned route,
+        const QString& url,
+        unsigned kcal,
+        unsigned coolDownTimeSeconds,
+        unsigned coolDownDistanceMeters,
+        float weight,
+        unsigned weather,
+        unsigned weatherTemperature,
+        const QString& where,
+        float bmi,
+        unsigned gramsOfFatBurnt,
+        unsigned source
+) {
+    uintColumns[YEAR].push_back(year);
+    uintColumns[MONTH].push_back(month);
+    uintColumns[DAY].push_back(day);
+    stringColumns[WHEN].append(when);
+    uintColumns[PHASE].push_back(phase);
+    categoricalColumns[ACTIVITY].push_back(activity);
+    stringColumns[DESCRIPTION].append(description);
+    uintColumns[COMMUTE].push_back(commute?1:0);
+    uintColumns[TOTAL_TIME_SECONDS].push_back(totalTimeSeconds);
+    uintColumns[TOTAL_DISTANCE_METERS].push_back(totalDistanceMeters);
+    uintColumns[WARM_UP_TIME_SECONDS].push_back(warmUpTimeSeconds);
+    uintColumns[WARM_UP_DISTANCE_METERS].push_back(warmUpDistanceMeters);
+    uintColumns[TIME_SECONDS].push_back(timeSeconds);
+    uintColumns[DISTANCE_METERS].push_back(distanceMeters);
+    categoricalColumns[INTENSITY].push_back(intensity);
+    uintColumns[SQUATS].push_back(squats);
+    uintColumns[PUSH_UPS].push_back(pushUps);
+    uintColumns[CRUNCHES].push_back(crunches);
+    uintColumns[TURTLES].push_back(turtles);
+    uintColumns[CALFS].push_back(calfs);
+    uintColumns[REPETITIONS].push_back(repetitions);
+    floatColumns[AVG_SPEED].push_back(avgSpeed);
+    floatColumns[MAX_SPEED].push_back(maxSpeed);
+    uintColumns[ELEVATION_GAIN].push_back(elevationGain);
+    uintColumns[AVG_WATTS].push_back(avgWatts);
+    uintColumns[MAX_WATTS].push_back(maxWatts);
+    categoricalColumns[GEAR].push_back(gear);
+    categoricalColumns[ROUTE].push_back(route);
+    stringColumns[URL].append(url);
+    uintColumns[KCAL].push_back(kcal);
+    uintColumns[COOL_DOWN_TIME_SECONDS].push_back(coolDownTimeSeconds);
+    uintColumns[COOL_DOWN_DISTANCE_METERS].push_back(coolDownDistanceMeters);
+    floatColumns[WEIGHT].push_back(weight);
+    categoricalColumns[WEATHER].push_back(weather);
+    uintColumns[WEATHER_TEMPERATURE].push_back(weatherTemperature);
+    stringColumns[WHERE].append(where);
+    floatColumns[BMI].push_back(bmi);
+    uintColumns[GRAMS_OF_FAT_BURNT].push_back(gramsOfFatBurnt);
+    categoricalColumns[SOURCE].push_back(source);
+
+    rows++;
+}
+
+void DatasetColumns::appendRow(
+        const unsigned uints[UINT_COLUMN_COUNT],
+        const float floats[FLOAT_COLUMN_COUNT],
+        const string_view strings[STRING_COLUMN_COUNT],
+        const unsigned categoricals[CATEGORICAL_COLUMN_COUNT])
+{
+    for(int c=0; c<UINT_COLUMN_COUNT; c++) {
+        uintColumns[c].push_back(uints[c]);
+    }
+    for(int c=0; c<FLOAT_COLUMN_COUNT; c++) {
+        floatColumns[c].push_back(floats[c]);
+    }
+    for(int c=0; c<STRING_COLUMN_COUNT; c++) {
+        stringColumns[c].append(strings[c].data(), strings[c].size());
+    }
+    for(int c=0; c<CATEGORICAL_COLUMN_COUNT; c++) {
+        categoricalColumns[c].push_back(categoricals[c]);
+    }
+
+    rows++;
+}
+
+void DatasetColumns::spliceRows(DatasetColumns& src)
+{
+    for(int c=0; c<UINT_COLUMN_COUNT; c++) spliceColumn(uintColumns[c], src.uintColumns[c]);
+    for(int c=0; c<FLOAT_COLUMN_COUNT; c++) spliceColumn(floatColumns[c], src.floatColumns[c]);
+    for(int c=0; c<STRING_COLUMN_COUNT; c++) stringColumns[c].splice(src.stringColumns[c]);
+    for(int c=0; c<CATEGORICAL_COLUMN_COUNT; c++) {
+        // batch has its own dictionary: translate its codes once per distinct value
+        vector<unsigned> translation{};
+        translation.reserve(src.features[c].size());
+        for(const QString& value:src.features[c].getValues()) {
+            translation.push_back(features[c].intern(value));
+        }
+        vector<unsigned>& column = categoricalColumns[c];
+        column.reserve(column.size()+src.categoricalColumns[c].size());
+        for(unsigned code:src.categoricalColumns[c]) {
+            column.push_back(translation[code]);
+        }
+        src.categoricalColumns[c].clear();
+        src.features[c].clear();
+    }
+    rows += src.rows;
+    src.rows = 0;
+}
+
+void DatasetColumns::insertRow(size_t row, const DatasetColumns& src, size_t srcRow)
+{
+    forEachColumn(src, [row, srcRow](auto& column, const auto& srcColumn) {
+        column.insert(column.begin()+row, srcColumn[srcRow]);
+    });
+    for(int c=0; c<STRING_COLUMN_COUNT; c++) {
+        stringColumns[c].insert(row, src.stringColumns[c], srcRow);
+    }
+    for(int c=0; c<CATEGORICAL_COLUMN_COUNT; c++) {
+        unsigned code = translateCode(static_cast<CategoricalColumn>(c), src, srcRow);
+        categoricalColumns[c].insert(categoricalColumns[c].begin()+row, code);
+    }
+    rows++;
+}
+
+void DatasetColumns::setRow(size_t row, const DatasetColumns& src, size_t srcRow)
+{
+    forEachColumn(src, [row, srcRow](auto& column, const auto& srcColumn) {
+        column[row] = srcColumn[srcRow];
+    });
+    for(int c=0; c<STRING_COLUMN_COUNT; c++) {
+        stringColumns[c].set(row, src.stringColumns[c], srcRow);
+    }
+    for(int c=0; c<CATEGORICAL_COLUMN_COUNT; c++) {
+        categoricalColumns[c][row] = translateCode(static_cast<CategoricalColumn>(c), src, srcRow);
+    }
+}
+
+void DatasetColumns::eraseRow(size_t row)
+{
+    forEachColumn([row](auto& column) {
+        column.erase(column.begin()+row);
+    });
+    for(Utf8Column& column:stringColumns) {
+        column.erase(row);
+    }
+    rows--;
+}
+
+void DatasetColumns::swapRows(size_t a, size_t b)
+{
+    forEachColumn([a, b](auto& column) {
+        swap(column[a], column[b]);
+    });
+    for(Utf8Column& column:stringColumns) {
+        column.swap(a, b);
+    }
+}
+
+} // namespace etl76
@@ -0,0 +1,224 @@
+/*
+ dataset_columns.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_COLUMNS_H
+#define ETL76_DATASET_COLUMNS_H
+
+#include <vector>
+
+#include <QString>
+
+#include "categorical_feature.h"
+#include "utf8_column.h"
+
+namespace etl76 {
+
+/**
+ * @brief Dataset columns.
+ *
+ * Columnar (struct of arrays) store of dataset instances: there is one
+ * contiguous array per column and row R of the dataset is the R-th item
+ * of every array. Scans and aggregations over a column touch only
+ * the column's bytes.
+ *
+ * Columns are grouped by type - see enums below. Categorical columns
+ * store codes of values interned in per column dictionaries.
+ * String columns store UTF-8 and decode QStrings on demand.
+ */
+class DatasetColumns
+{
+    // snapshot is loaded to/saved from columns by blocks
+    friend class DatasetSnapshot;
+
+public:
+    enum UIntColumn {
+        YEAR,
+        MONTH,
+        DAY,
+        PHASE,
+        COMMUTE,
+        TOTAL_TIME_SECONDS,
+        TOTAL_DISTANCE_METERS,
+        WARM_UP_TIME_SECONDS,
+        WARM_UP_DISTANCE_METERS,
+        TIME_SECONDS,
+        DISTANCE_METERS,
+        SQUATS,
+        PUSH_UPS,
+        CRUNCHES,
+        TURTLES,
+        CALFS,
+        REPETITIONS,
+        ELEVATION_GAIN,
+        AVG_WATTS,
+        MAX_WATTS,
+        KCAL,
+        COOL_DOWN_TIME_SECONDS,
+        COOL_DOWN_DISTANCE_METERS,
+        WEATHER_TEMPERATURE,
+        GRAMS_OF_FAT_BURNT,
+
+        UINT_COLUMN_COUNT
+    };
+
+    enum FloatColumn {
+        AVG_SPEED,
+        MAX_SPEED,
+        WEIGHT,
+        BMI,
+
+        FLOAT_COLUMN_COUNT
+    };
+
+    enum StringColumn {
+        WHEN,
+        DESCRIPTION,
+        URL,
+        WHERE,
+
+        STRING_COLUMN_COUNT
+    };
+
+    enum CategoricalColumn {
+        ACTIVITY,
+        INTENSITY,
+        GEAR,
+        ROUTE,
+        WEATHER,
+        SOURCE,
+
+        CATEGORICAL_COLUMN_COUNT
+    };
+
+private:
+    size_t rows;
+
+    std::vector<unsigned> uintColumns[UINT_COLUMN_COUNT];
+    std::vector<float> floatColumns[FLOAT_COLUMN_COUNT];
+    Utf8Column stringColumns[STRING_COLUMN_COUNT];
+    std::vector<unsigned> categoricalColumns[CATEGORICAL_COLUMN_COUNT];
+    CategoricalFeature features[CATEGORICAL_COLUMN_COUNT];
+
+    unsigned translateCode(CategoricalColumn c, const DatasetColumns& src, size_t srcRow);
+
+    template<class Op> void forEachColumn(Op op);
+    template<class Op> void forEachColumn(const DatasetColumns& src, Op op);
+
+public:
+    DatasetColumns();
+    DatasetColumns(const DatasetColumns&) = delete;
+    DatasetColumns(const DatasetColumns&&) = delete;
+    DatasetColumns &operator=(const DatasetColumns&) = delete;
+    DatasetColumns &operator=(const DatasetColumns&&) = delete;
+
+    size_t size() const { return rows; }
+    /**
+     * @brief Bytes held by the columns (allocated capacity and string data).
+     */
+    size_t getByteSize() const;
+
+    const std::vector<unsigned>& getColumn(UIntColumn c) const { return uintColumns[c]; }
+    const std::vector<float>& getColumn(FloatColumn c) const { return floatColumns[c]; }
+    const Utf8Column& getColumn(StringColumn c) const { return stringColumns[c]; }
+    const std::vector<unsigned>& getColumn(CategoricalColumn c) const { return categoricalColumns[c]; }
+    const CategoricalFeature& getFeature(CategoricalColumn c) const { return features[c]; }
+    CategoricalFeature& getFeature(CategoricalColumn c) { return features[c]; }
+
+    unsigned get(UIntColumn c, size_t row) const { return uintColumns[c][row]; }
+    float get(FloatColumn c, size_t row) const { return floatColumns[c][row]; }
+    // decoded on the 1st call - see Utf8Column
+    const QString& get(StringColumn c, size_t row) const { return stringColumns[c].get(row); }
+    std::string_view getUtf8(StringColumn c, size_t row) const { return stringColumns[c].getUtf8(row); }
+    CategoricalValue get(CategoricalColumn c, size_t row) const {
+        return CategoricalValue{&features[c], categoricalColumns[c][row]};
+    }
+
+    void reserve(size_t capacity);
+    void clear();
+    /**
+     * @brief Copy all rows of other columns - used to save immutable copy of the dataset.
+     */
+    void assign(const DatasetColumns& src);
+
+    /**
+     * @brief Append row - categorical values are codes from features of these columns.
+     */
+    void appendRow(
+            unsigned year,
+            unsigned month,
+            unsigned day,
+            const QString& when,
+            unsigned phase,
+            unsigned activity,
+            const QString& description,
+            bool commute,
+            unsigned totalTimeSeconds,
+            unsigned totalDistanceMeters,
+            unsigned warmUpTimeSeconds,
+            unsigned warmUpDistanceMeters,
+            unsigned timeSeconds,
+            unsigned distanceMeters,
+            unsigned intensity,
+            unsigned squats,
+            unsigned pushUps,
+            unsigned crunches,
+            unsigned turtles,
+            unsigned calfs,
+            unsigned repetitions,
+            float avgSpeed,
+            float maxSpeed,
+            unsigned elevationGain,
+            unsigned avgWatts,
+            unsigned maxWatts,
+            unsigned gear,
+            unsigned route,
+            const QString& url,
+            unsigned kcal,
+            unsigned coolDownTimeSeconds,
+            unsigned coolDownDistanceMeters,
+            float weight,
+            unsigned weather,
+            unsigned weatherTemperature,
+            const QString& where,
+            float bmi,
+            unsigned gramsOfFatBurnt,
+            unsigned source
+    );
+    /**
+     * @brief Append row staged by column type - strings are UTF-8 and categorical
+     * values are codes from features of these columns.
+     */
+    void appendRow(
+            const unsigned uints[UINT_COLUMN_COUNT],
+            const float floats[FLOAT_COLUMN_COUNT],
+            const std::string_view strings[STRING_COLUMN_COUNT],
+            const unsigned categoricals[CATEGORICAL_COLUMN_COUNT]
+    );
+    /**
+     * @brief Move all rows of other columns (batch) to the end - batch is left empty.
+     */
+    void spliceRows(DatasetColumns& src);
+    void insertRow(size_t row, const DatasetColumns& src, size_t srcRow);
+    void setRow(size_t row, const DatasetColumns& src, size_t srcRow);
+    void eraseRow(size_t row);
+    void swapRows(size_t a, size_t b);
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_COLUMNS_H
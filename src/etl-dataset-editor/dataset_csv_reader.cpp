@@ -0,0 +1,217 @@
+/*
+ dataset_csv_reader.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_csv_reader.h"
+
+#include <cstring>
+
+namespace etl76 {
+
+using namespace std;
+
+typedef DatasetCsvReader::Converter Converter;
+
+const DatasetCsvReader::KnownColumn DatasetCsvReader::KNOWN_COLUMNS[] = {
+    {"year", Converter::UINT, DatasetColumns::YEAR, true},
+    {"month", Converter::UINT, DatasetColumns::MONTH, true},
+    {"day", Converter::UINT, DatasetColumns::DAY, true},
+    {"when", Converter::STRING, DatasetColumns::WHEN, false},
+    {"phase", Converter::UINT, DatasetColumns::PHASE, false},
+    {"activity", Converter::CATEGORICAL, DatasetColumns::ACTIVITY, false},
+    {"description", Converter::STRING, DatasetColumns::DESCRIPTION, false},
+    {"commute", Converter::BOOL, DatasetColumns::COMMUTE, false},
+    {"total_time_seconds", Converter::UINT, DatasetColumns::TOTAL_TIME_SECONDS, false},
+    {"total_distance_meters", Converter::UINT, DatasetColumns::TOTAL_DISTANCE_METERS, false},
+    {"warm_up_time_seconds", Converter::UINT, DatasetColumns::WARM_UP_TIME_SECONDS, false},
+    {"warm_up_distance_meters", Converter::UINT, DatasetColumns::WARM_UP_DISTANCE_METERS, false},
+    {"time_seconds", Converter::UINT, DatasetColumns::TIME_SECONDS, false},
+    {"distance_meters", Converter::UINT, DatasetColumns::DISTANCE_METERS, false},
+    {"intensity", Converter::CATEGORICAL, DatasetColumns::INTENSITY, false},
+    {"squats", Converter::UINT, DatasetColumns::SQUATS, false},
+    {"push_ups", Converter::UINT, DatasetColumns::PUSH_UPS, false},
+    {"crunches", Converter::UINT, DatasetColumns::CRUNCHES, false},
+    {"turtles", Converter::UINT, DatasetColumns::TURTLES, false},
+    {"calfs", Converter::UINT, DatasetColumns::CALFS, false},
+    {"repetitions", Converter::UINT, DatasetColumns::REPETITIONS, false},
+    {"avg_speed", Converter::FLOAT, DatasetColumns::AVG_SPEED, false},
+    {"max_speed", Converter::FLOAT, DatasetColumns::MAX_SPEED, false},
+    {"elevation_gain", Converter::UINT, DatasetColumns::ELEVATION_GAIN, false},
+    {"avg_watts", Converter::UINT, DatasetColumns::AVG_WATTS, false},
+    {"max_watts", Converter::UINT, DatasetColumns::MAX_WATTS, false},
+    {"gear", Converter::CATEGORICAL, DatasetColumns::GEAR, false},
+    {"route", Converter::CATEGORICAL, DatasetColumns::ROUTE, false},
+    {"url", Converter::STRING, DatasetColumns::URL, false},
+    {"kcal", Converter::UINT, DatasetColumns::KCAL, false},
+    {"cool_down_time_seconds", Converter::UINT, DatasetColumns::COOL_DOWN_TIME_SECONDS, false},
+    {"cool_down_distance_meters", Converter::UINT, DatasetColumns::COOL_DOWN_DISTANCE_METERS, false},
+    {"weight", Converter::FLOAT, DatasetColumns::WEIGHT, false},
+    {"weather", Converter::CATEGORICAL, DatasetColumns::WEATHER, false},
+    {"weather_temperature", Converter::UINT, DatasetColumns::WEATHER_TEMPERATURE, false},
+    {"where", Converter::STRING, DatasetColumns::WHERE, false},
+    {"bmi", Converter::FLOAT, DatasetColumns::BMI, false},
+    {"grams_of_fat_burnt", Converter::UINT, DatasetColumns::GRAMS_OF_FAT_BURNT, false},
+    {"source", Converter::CATEGORICAL, DatasetColumns::SOURCE, false},
+};
+
+const size_t DatasetCsvReader::KNOWN_COLUMN_COUNT
+    = sizeof(DatasetCsvReader::KNOWN_COLUMNS)/sizeof(DatasetCsvReader::KNOWN_COLUMNS[0]);
+
+// the longest number parsed w/o allocation
+static const size_t MAX_NUMBER_SIZE = 63;
+
+DatasetCsvReader::DatasetCsvReader()
+    : fileColumns(),
+      unescaped()
+{
+    clearRow();
+}
+
+void DatasetCsvReader::clearRow()
+{
+    fill(begin(uints), end(uints), 0);
+    fill(begin(floats), end(floats), 0.f);
+    fill(begin(strings), end(strings), string_view{});
+    fill(begin(categoricals), end(categoricals), CategoricalFeature::EMPTY_CODE);
+}
+
+void DatasetCsvReader::parseHeader(char* line)
+{
+    fileColumns.clear();
+    clearRow();
+
+    bool found[KNOWN_COLUMN_COUNT];
+    fill(found, found+KNOWN_COLUMN_COUNT, false);
+    while(line) {
+        char* nameBegin;
+        char* nameEnd;
+        io::detail::chop_next_column<QuotePolicy>(line, nameBegin, nameEnd);
+        TrimPolicy::trim(nameBegin, nameEnd);
+        QuotePolicy::unescape(nameBegin, nameEnd);
+
+        FileColumn fileColumn{Converter::SKIP, 0, nullptr};
+        for(size_t k=0; k<KNOWN_COLUMN_COUNT; k++) {
+            if(!strcmp(nameBegin, KNOWN_COLUMNS[k].name)) {
+                if(found[k]) {
+                    io::error::duplicated_column_in_header e;
+                    e.set_column_name(nameBegin);
+                    throw e;
+                }
+                found[k] = true;
+                fileColumn = FileColumn{KNOWN_COLUMNS[k].converter, KNOWN_COLUMNS[k].target, KNOWN_COLUMNS[k].name};
+                break;
+            }
+        }
+        fileColumns.push_back(fileColumn);
+    }
+    for(size_t k=0; k<KNOWN_COLUMN_COUNT; k++) {
+        if(KNOWN_COLUMNS[k].required && !found[k]) {
+            io::error::missing_column_in_header e;
+            e.set_column_name(KNOWN_COLUMNS[k].name);
+            throw e;
+        }
+    }
+
+    unescaped.resize(fileColumns.size());
+}
+
+void DatasetCsvReader::setHeader(const DatasetCsvReader& header)
+{
+    fileColumns = header.fileColumns;
+    unescaped.resize(fileColumns.size());
+    clearRow();
+}
+
+/*
+ * Number is copied to a terminated buffer - the parser reads it up to NUL.
+ */
+template<class T>
+static void parseNumber(const char* begin, const char* end, T& value, const char* name)
+{
+    char buffer[MAX_NUMBER_SIZE+1];
+    string longNumber{};
+    char* field = buffer;
+    const size_t size = static_cast<size_t>(end-begin);
+    if(size <= MAX_NUMBER_SIZE) {
+        memcpy(buffer, begin, size);
+        buffer[size] = 0;
+    } else {
+        longNumber.assign(begin, end);
+        field = &longNumber[0];
+    }
+
+    try {
+        try {
+            io::detail::parse<DatasetCsvReader::OverflowPolicy>(field, value);
+        } catch(io::error::with_column_content& e) {
+            e.set_column_content(field);
+            throw;
+        }
+    } catch(io::error::with_column_name& e) {
+        e.set_column_name(name);
+        throw;
+    }
+}
+
+void DatasetCsvReader::parseRow(const char* begin, const char* end, DatasetColumns& columns)
+{
+    const char* cursor = begin;
+    for(size_t i=0; i<fileColumns.size(); i++) {
+        if(cursor == nullptr) {
+            throw io::error::too_few_columns();
+        }
+        const char* fieldBegin = cursor;
+        const char* fieldEnd = QuotePolicy::find_next_column_end(cursor, end);
+        cursor = fieldEnd != end ? fieldEnd+1 : nullptr;
+
+        const FileColumn& fileColumn = fileColumns[i];
+        if(fileColumn.converter == Converter::SKIP) {
+            continue;
+        }
+        TrimPolicy::trim(fieldBegin, fieldEnd);
+        QuotePolicy::unescape(fieldBegin, fieldEnd, unescaped[i]);
+        switch(fileColumn.converter) {
+        case Converter::SKIP:
+            break;
+        case Converter::UINT:
+            parseNumber(fieldBegin, fieldEnd, uints[fileColumn.target], fileColumn.name);
+            break;
+        case Converter::BOOL:
+            parseNumber(fieldBegin, fieldEnd, uints[fileColumn.target], fileColumn.name);
+            uints[fileColumn.target] = uints[fileColumn.target] != 0;
+            break;
+        case Converter::FLOAT:
+            parseNumber(fieldBegin, fieldEnd, floats[fileColumn.target], fileColumn.name);
+            break;
+        case Converter::STRING:
+            strings[fileColumn.target] = string_view{fieldBegin, static_cast<size_t>(fieldEnd-fieldBegin)};
+            break;
+        case Converter::CATEGORICAL:
+            categoricals[fileColumn.target] = columns.getFeature(
+                static_cast<DatasetColumns::CategoricalColumn>(fileColumn.target)).intern(
+                    string_view{fieldBegin, static_cast<size_t>(fieldEnd-fieldBegin)});
+            break;
+        }
+    }
+    if(cursor != nullptr) {
+        throw io::error::too_many_columns();
+    }
+
+    columns.appendRow(uints, floats, strings, categoricals);
+}
+
+} // namespace etl76
@@ -0,0 +1,169 @@
+/*
+ dataset_csv_reader.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_CSV_READER_H
+#define ETL76_DATASET_CSV_READER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv.h"
+#include "dataset_columns.h"
+
+namespace etl76 {
+
+/**
+ * @brief Dataset CSV reader.
+ *
+ * Columns of the file are mapped to dataset columns by the header when
+ * the file is opened - known columns may be in any order, unknown columns
+ * (like a leading unnamed index) are skipped and dataset columns missing
+ * in the file get default values (0 or empty). Only the date is required.
+ *
+ * Each file column is compiled to a converter (parser of the column type
+ * and index of the target column) so that a row is parsed by one pass over
+ * its fields directly to the staged row - no per row lookup of names.
+ *
+ * Lines are parsed as read only views (e.g. to a file mapping): strings
+ * and categorical values are taken from the line, numbers are copied
+ * to a small terminated buffer for the parser.
+ */
+class DatasetCsvReader
+{
+public:
+    typedef io::trim_chars<' '> TrimPolicy;
+    typedef io::double_quote_escape<',','"'> QuotePolicy;
+    typedef io::throw_on_overflow OverflowPolicy;
+
+    enum class Converter {
+        SKIP,
+        UINT,
+        BOOL,
+        FLOAT,
+        STRING,
+        CATEGORICAL
+    };
+
+    /**
+     * @brief Dataset column known to the reader.
+     */
+    struct KnownColumn
+    {
+        const char* name;
+        Converter converter;
+        unsigned target;
+        bool required;
+    };
+
+    static const KnownColumn KNOWN_COLUMNS[];
+    static const size_t KNOWN_COLUMN_COUNT;
+
+private:
+    struct FileColumn
+    {
+        Converter converter;
+        unsigned target;
+        // known column name (error reporting)
+        const char* name;
+    };
+
+    std::vector<FileColumn> fileColumns;
+
+    // staged row initialized by defaults - missing columns are never written
+    unsigned uints[DatasetColumns::UINT_COLUMN_COUNT];
+    float floats[DatasetColumns::FLOAT_COLUMN_COUNT];
+    std::string_view strings[DatasetColumns::STRING_COLUMN_COUNT];
+    unsigned categoricals[DatasetColumns::CATEGORICAL_COLUMN_COUNT];
+    // per file column: quoted value w/ escaped quotes is unescaped there
+    std::vector<std::string> unescaped;
+
+    void clearRow();
+
+public:
+    DatasetCsvReader();
+    DatasetCsvReader(const DatasetCsvReader&) = delete;
+    DatasetCsvReader(const DatasetCsvReader&&) = delete;
+    DatasetCsvReader &operator=(const DatasetCsvReader&) = delete;
+    DatasetCsvReader &operator=(const DatasetCsvReader&&) = delete;
+
+    /**
+     * @brief Compile converters of the header line - throws io::error
+     * exceptions if a required column is missing or a column is duplicated.
+     */
+    void parseHeader(char* line);
+    /**
+     * @brief Use converters compiled by reader of another part of the same file.
+     */
+    void setHeader(const DatasetCsvReader& header);
+
+    /**
+     * @brief Parse the line [begin, end) and append it as a row to the columns.
+     */
+    void parseRow(const char* begin, const char* end, DatasetColumns& columns);
+
+    /**
+     * @brief Read header and all rows from the line reader to the columns.
+     */
+    template<class LineReader>
+    void readHeader(LineReader& in);
+    template<class LineReader>
+    void readRows(LineReader& in, DatasetColumns& columns);
+};
+
+template<class LineReader>
+void DatasetCsvReader::readHeader(LineReader& in)
+{
+    try {
+        const char* begin;
+        const char* end;
+        if(!in.next_line(begin, end)) {
+            throw io::error::header_missing();
+        }
+        // header is parsed once - in its own copy
+        std::string line{begin, end};
+        parseHeader(&line[0]);
+    } catch(io::error::with_file_name& e) {
+        e.set_file_name(in.get_truncated_file_name());
+        throw;
+    }
+}
+
+template<class LineReader>
+void DatasetCsvReader::readRows(LineReader& in, DatasetColumns& columns)
+{
+    try {
+        try {
+            const char* begin;
+            const char* end;
+            while(in.next_line(begin, end)) {
+                parseRow(begin, end, columns);
+            }
+        } catch(io::error::with_file_name& e) {
+            e.set_file_name(in.get_truncated_file_name());
+            throw;
+        }
+    } catch(io::error::with_file_line& e) {
+        e.set_file_line(in.get_file_line());
+        throw;
+    }
+}
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_CSV_READER_H
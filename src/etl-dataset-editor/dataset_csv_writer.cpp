@@ -0,0 +1,248 @@
+/*
+ dataset_csv_writer.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_csv_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace etl76 {
+
+using namespace std;
+
+// the longest formatted number (float w/ exponent, 32b unsigned)
+static const size_t MAX_NUMBER_SIZE = 32;
+
+DatasetCsvWriter::DatasetCsvWriter()
+    : buffer(),
+      used(0)
+{
+}
+
+char* DatasetCsvWriter::reserve(size_t bytes)
+{
+    if(used+bytes > buffer.size()) {
+        buffer.resize(max(buffer.size()*2, used+bytes));
+    }
+    return buffer.data()+used;
+}
+
+void DatasetCsvWriter::append(const char* data, size_t size)
+{
+    if(!size) {
+        // empty value may have no data - it must not be passed to memcpy()
+        return;
+    }
+    memcpy(reserve(size), data, size);
+    used += size;
+}
+
+void DatasetCsvWriter::appendUnsigned(unsigned value)
+{
+    char* begin = reserve(MAX_NUMBER_SIZE);
+    used = to_chars(begin, begin+MAX_NUMBER_SIZE, value).ptr - buffer.data();
+}
+
+void DatasetCsvWriter::appendFloat(float value)
+{
+    // shortest text which reads back to the same float - load/save does not drift
+    char* begin = reserve(MAX_NUMBER_SIZE);
+    used = to_chars(begin, begin+MAX_NUMBER_SIZE, value).ptr - buffer.data();
+}
+
+/*
+ * Value is quoted if it contains separator or quote - quotes are doubled.
+ */
+void DatasetCsvWriter::quote(size_t from)
+{
+    size_t size = used-from;
+    const char* value = buffer.data()+from;
+    size_t quotes = count(value, value+size, '"');
+    if(!quotes && !memchr(value, ',', size)) {
+        return;
+    }
+
+    // value is moved from its end as the quoted value is longer
+    char* out = reserve(quotes+2) + quotes+1;
+    const char* in = buffer.data()+used;
+    *out = '"';
+    while(in != buffer.data()+from) {
+        *--out = *--in;
+        if(*in == '"') {
+            *--out = '"';
+        }
+    }
+    *--out = '"';
+    used += quotes+2;
+}
+
+void DatasetCsvWriter::appendString(string_view value)
+{
+    size_t from = used;
+    append(value.data(), value.size());
+    quote(from);
+}
+
+void DatasetCsvWriter::appendRow(const DatasetColumns& c, size_t row)
+{
+    auto appendCategorical = [&](DatasetColumns::CategoricalColumn column) {
+        appendString(c.getFeature(column).getUtf8Value(c.getColumn(column)[row]));
+    };
+
+    appendUnsigned(c.get(DatasetColumns::YEAR, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::MONTH, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::DAY, row));
+    appendSeparator();
+    appendString(c.getUtf8(DatasetColumns::WHEN, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::PHASE, row));
+    appendSeparator();
+    appendCategorical(DatasetColumns::ACTIVITY);
+    appendSeparator();
+    appendString(c.getUtf8(DatasetColumns::DESCRIPTION, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::COMMUTE, row) != 0);
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::TOTAL_TIME_SECONDS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::TOTAL_DISTANCE_METERS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::WARM_UP_TIME_SECONDS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::WARM_UP_DISTANCE_METERS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::TIME_SECONDS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::DISTANCE_METERS, row));
+    appendSeparator();
+    appendCategorical(DatasetColumns::INTENSITY);
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::SQUATS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::PUSH_UPS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::CRUNCHES, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::TURTLES, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::CALFS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::REPETITIONS, row));
+    appendSeparator();
+    appendFloat(c.get(DatasetColumns::AVG_SPEED, row));
+    appendSeparator();
+    appendFloat(c.get(DatasetColumns::MAX_SPEED, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::ELEVATION_GAIN, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::AVG_WATTS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::MAX_WATTS, row));
+    appendSeparator();
+    appendCategorical(DatasetColumns::GEAR);
+    appendSeparator();
+    appendCategorical(DatasetColumns::ROUTE);
+    appendSeparator();
+    appendString(c.getUtf8(DatasetColumns::URL, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::KCAL, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::COOL_DOWN_TIME_SECONDS, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::COOL_DOWN_DISTANCE_METERS, row));
+    appendSeparator();
+    appendFloat(c.get(DatasetColumns::WEIGHT, row));
+    appendSeparator();
+    appendCategorical(DatasetColumns::WEATHER);
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::WEATHER_TEMPERATURE, row));
+    appendSeparator();
+    appendString(c.getUtf8(DatasetColumns::WHERE, row));
+    appendSeparator();
+    appendFloat(c.get(DatasetColumns::BMI, row));
+    appendSeparator();
+    appendUnsigned(c.get(DatasetColumns::GRAMS_OF_FAT_BURNT, row));
+    appendSeparator();
+    appendCategorical(DatasetColumns::SOURCE);
+    append("\n", 1);
+}
+
+static void writeBlock(int fd, const string& filePath, const char* data, size_t size)
+{
+    while(size) {
+        ssize_t written = ::write(fd, data, size);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            int error = errno;
+            close(fd);
+            throw EtlRuntimeException(
+                "Unable to write file "+filePath+": "+strerror(error)
+            );
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void DatasetCsvWriter::write(const string& filePath, const char* header, const DatasetColumns& columns)
+{
+    int fd = open(filePath.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fd < 0) {
+        throw EtlRuntimeException(
+            "Unable to create file "+filePath+": "+strerror(errno)
+        );
+    }
+
+    // rows are flushed before the buffer must grow
+    buffer.resize(max(buffer.size(), FLUSH_SIZE + FLUSH_SIZE/4));
+    clear();
+    append(header, strlen(header));
+    for(size_t row=0; row<columns.size(); row++) {
+        appendRow(columns, row);
+        if(used >= FLUSH_SIZE) {
+            writeBlock(fd, filePath, buffer.data(), used);
+            clear();
+        }
+    }
+    writeBlock(fd, filePath, buffer.data(), used);
+    clear();
+
+    // file is complete on disk before it is renamed over the previous version
+    if(fsync(fd) != 0) {
+        int error = errno;
+        close(fd);
+        throw EtlRuntimeException(
+            "Unable to sync file "+filePath+": "+strerror(error)
+        );
+    }
+    if(close(fd) != 0) {
+        throw EtlRuntimeException(
+            "Unable to close file "+filePath+": "+strerror(errno)
+        );
+    }
+}
+
+} // namespace etl76
@@ -0,0 +1,82 @@
+/*
+ dataset_csv_writer.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_CSV_WRITER_H
+#define ETL76_DATASET_CSV_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dataset_columns.h"
+#include "exceptions.h"
+
+namespace etl76 {
+
+/**
+ * @brief Dataset CSV writer.
+ *
+ * Rows are formatted directly from dataset columns to one reusable buffer:
+ * numbers w/ std::to_chars(), strings and categorical values are copied
+ * as UTF-8 (kept so by string columns and dictionaries) and quoted in
+ * place. The buffer is written to the file by large blocks - there is
+ * no allocation per row or field.
+ */
+class DatasetCsvWriter
+{
+public:
+    // buffer is written to the file once it is this large
+    static const size_t FLUSH_SIZE = 1<<20;
+
+private:
+    std::vector<char> buffer;
+    size_t used;
+
+    char* reserve(size_t bytes);
+    void append(const char* data, size_t size);
+    void appendSeparator() { append(", ", 2); }
+    void appendUnsigned(unsigned value);
+    void appendFloat(float value);
+    void appendString(std::string_view value);
+    void quote(size_t from);
+
+public:
+    DatasetCsvWriter();
+    DatasetCsvWriter(const DatasetCsvWriter&) = delete;
+    DatasetCsvWriter(const DatasetCsvWriter&&) = delete;
+    DatasetCsvWriter &operator=(const DatasetCsvWriter&) = delete;
+    DatasetCsvWriter &operator=(const DatasetCsvWriter&&) = delete;
+
+    /**
+     * @brief Append row formatted as CSV w/ trailing newline to the buffer.
+     */
+    void appendRow(const DatasetColumns& columns, size_t row);
+
+    const char* data() const { return buffer.data(); }
+    size_t size() const { return used; }
+    void clear() { used = 0; }
+
+    /**
+     * @brief Write header and all rows of columns to the file and sync it.
+     */
+    void write(const std::string& filePath, const char* header, const DatasetColumns& columns);
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_CSV_WRITER_H
@@ -0,0 +1,628 @@
+/*
+ dataset_filter.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_filter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+static const DatasetFilter::Field FIELDS[] = {
+    {"year", DatasetFilter::YEAR, DatasetColumns::YEAR, DatasetFilter::NO_UNIT},
+    {"date", DatasetFilter::DATE, DatasetColumns::YEAR, DatasetFilter::NO_UNIT},
+    {"month", DatasetFilter::UINT, DatasetColumns::MONTH, DatasetFilter::NO_UNIT},
+    {"day", DatasetFilter::UINT, DatasetColumns::DAY, DatasetFilter::NO_UNIT},
+    {"when", DatasetFilter::STRING, DatasetColumns::WHEN, DatasetFilter::NO_UNIT},
+    {"phase", DatasetFilter::UINT, DatasetColumns::PHASE, DatasetFilter::NO_UNIT},
+    {"activity", DatasetFilter::CATEGORICAL, DatasetColumns::ACTIVITY, DatasetFilter::NO_UNIT},
+    {"description", DatasetFilter::STRING, DatasetColumns::DESCRIPTION, DatasetFilter::NO_UNIT},
+    {"commute", DatasetFilter::UINT, DatasetColumns::COMMUTE, DatasetFilter::BOOLEAN},
+    {"total_time", DatasetFilter::UINT, DatasetColumns::TOTAL_TIME_SECONDS, DatasetFilter::SECONDS},
+    {"total_distance", DatasetFilter::UINT, DatasetColumns::TOTAL_DISTANCE_METERS, DatasetFilter::METERS},
+    // time and distance as shown in the table
+    {"time", DatasetFilter::UINT, DatasetColumns::TOTAL_TIME_SECONDS, DatasetFilter::SECONDS},
+    {"distance", DatasetFilter::UINT, DatasetColumns::DISTANCE_METERS, DatasetFilter::METERS},
+    {"intensity", DatasetFilter::CATEGORICAL, DatasetColumns::INTENSITY, DatasetFilter::NO_UNIT},
+    {"squats", DatasetFilter::UINT, DatasetColumns::SQUATS, DatasetFilter::NO_UNIT},
+    {"push_ups", DatasetFilter::UINT, DatasetColumns::PUSH_UPS, DatasetFilter::NO_UNIT},
+    {"crunches", DatasetFilter::UINT, DatasetColumns::CRUNCHES, DatasetFilter::NO_UNIT},
+    {"turtles", DatasetFilter::UINT, DatasetColumns::TURTLES, DatasetFilter::NO_UNIT},
+    {"calfs", DatasetFilter::UINT, DatasetColumns::CALFS, DatasetFilter::NO_UNIT},
+    {"repetitions", DatasetFilter::UINT, DatasetColumns::REPETITIONS, DatasetFilter::NO_UNIT},
+    {"avg_speed", DatasetFilter::FLOAT, DatasetColumns::AVG_SPEED, DatasetFilter::NO_UNIT},
+    {"max_speed", DatasetFilter::FLOAT, DatasetColumns::MAX_SPEED, DatasetFilter::NO_UNIT},
+    {"elevation", DatasetFilter::UINT, DatasetColumns::ELEVATION_GAIN, DatasetFilter::METERS},
+    {"avg_watts", DatasetFilter::UINT, DatasetColumns::AVG_WATTS, DatasetFilter::NO_UNIT},
+    {"max_watts", DatasetFilter::UINT, DatasetColumns::MAX_WATTS, DatasetFilter::NO_UNIT},
+    {"gear", DatasetFilter::CATEGORICAL, DatasetColumns::GEAR, DatasetFilter::NO_UNIT},
+    {"route", DatasetFilter::CATEGORICAL, DatasetColumns::ROUTE, DatasetFilter::NO_UNIT},
+    {"url", DatasetFilter::STRING, DatasetColumns::URL, DatasetFilter::NO_UNIT},
+    {"kcal", DatasetFilter::UINT, DatasetColumns::KCAL, DatasetFilter::NO_UNIT},
+    {"weight", DatasetFilter::FLOAT, DatasetColumns::WEIGHT, DatasetFilter::KILOGRAMS},
+    {"weather", DatasetFilter::CATEGORICAL, DatasetColumns::WEATHER, DatasetFilter::NO_UNIT},
+    {"temperature", DatasetFilter::UINT, DatasetColumns::WEATHER_TEMPERATURE, DatasetFilter::NO_UNIT},
+    {"where", DatasetFilter::STRING, DatasetColumns::WHERE, DatasetFilter::NO_UNIT},
+    {"bmi", DatasetFilter::FLOAT, DatasetColumns::BMI, DatasetFilter::NO_UNIT},
+    {"fat", DatasetFilter::UINT, DatasetColumns::GRAMS_OF_FAT_BURNT, DatasetFilter::NO_UNIT},
+    {"source", DatasetFilter::CATEGORICAL, DatasetColumns::SOURCE, DatasetFilter::NO_UNIT},
+};
+
+static const DatasetFilter::Field DESCRIPTION_FIELD
+    = {"description", DatasetFilter::STRING, DatasetColumns::DESCRIPTION, DatasetFilter::NO_UNIT};
+
+DatasetFilter::DatasetFilter()
+    : expression(),
+      conjunctions()
+{
+}
+
+/*
+ * Parser
+ */
+
+class FilterParser
+{
+private:
+    const QString& text;
+    int position;
+
+public:
+    explicit FilterParser(const QString& text) : text(text), position(0) {}
+
+    [[noreturn]] void error(const string& message) const {
+        throw EtlUserException(message + " at position " + to_string(position+1) + " of the filter");
+    }
+
+    static bool isOperatorChar(QChar c) {
+        return c == '=' || c == '!' || c == '<' || c == '>' || c == '~';
+    }
+
+    bool atEnd() {
+        while(position < text.size() && text[position].isSpace()) {
+            position++;
+        }
+        return position >= text.size();
+    }
+
+    bool atOperator() { return !atEnd() && isOperatorChar(text[position]); }
+
+    /**
+     * @brief Quoted value or run of non-space (and non-operator) characters.
+     */
+    QString readToken(bool stopAtOperator) {
+        if(atEnd()) {
+            return QString{};
+        }
+        if(text[position] == '"') {
+            int end = text.indexOf('"', position+1);
+            if(end < 0) {
+                error("Missing closing quote");
+            }
+            QString token = text.mid(position+1, end-position-1);
+            position = end+1;
+            return token;
+        }
+        int start = position;
+        while(position < text.size()
+              && !text[position].isSpace()
+              && !(stopAtOperator && isOperatorChar(text[position])))
+        {
+            position++;
+        }
+        return text.mid(start, position-start);
+    }
+
+    DatasetFilter::Operator readOperator() {
+        static const struct { const char* symbol; DatasetFilter::Operator op; } OPERATORS[] = {
+            {"==", DatasetFilter::EQUAL},
+            {"!=", DatasetFilter::NOT_EQUAL},
+            {"!~", DatasetFilter::NOT_CONTAINS},
+            {"<=", DatasetFilter::LESS_EQUAL},
+            {">=", DatasetFilter::GREATER_EQUAL},
+            {"=", DatasetFilter::EQUAL},
+            {"<", DatasetFilter::LESS},
+            {">", DatasetFilter::GREATER},
+            {"~", DatasetFilter::CONTAINS},
+        };
+        for(const auto& o:OPERATORS) {
+            QString symbol{o.symbol};
+            if(text.mid(position, symbol.size()) == symbol) {
+                position += symbol.size();
+                return o.op;
+            }
+        }
+        error("Unknown operator");
+    }
+};
+
+static const DatasetFilter::Field* findField(const QString& name)
+{
+    const QString lowerName = name.toLower();
+    for(const DatasetFilter::Field& field:FIELDS) {
+        if(lowerName == field.name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Number w/ optional unit(s): 50km, 1h30min, 92.5kg.
+ */
+static bool parseQuantity(const QString& text, DatasetFilter::Unit unit, double& value)
+{
+    if(unit == DatasetFilter::BOOLEAN) {
+        const QString lowerText = text.toLower();
+        if(lowerText == "yes" || lowerText == "true" || lowerText == "1") {
+            value = 1;
+        } else if(lowerText == "no" || lowerText == "false" || lowerText == "0") {
+            value = 0;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    value = 0;
+    int position = 0;
+    while(position < text.size()) {
+        int start = position;
+        while(position < text.size() && (text[position].isDigit() || text[position] == '.')) {
+            position++;
+        }
+        bool ok;
+        double number = text.mid(start, position-start).toDouble(&ok);
+        if(!ok) {
+            return false;
+        }
+        start = position;
+        while(position < text.size() && text[position].isLetter()) {
+            position++;
+        }
+        const QString suffix = text.mid(start, position-start).toLower();
+
+        double factor;
+        if(suffix.isEmpty()) {
+            factor = 1;
+        } else if(unit == DatasetFilter::METERS && suffix == "m") {
+            factor = 1;
+        } else if(unit == DatasetFilter::METERS && suffix == "km") {
+            factor = 1000;
+        } else if(unit == DatasetFilter::SECONDS && suffix == "s") {
+            factor = 1;
+        } else if(unit == DatasetFilter::SECONDS && (suffix == "min" || suffix == "m")) {
+            factor = 60;
+        } else if(unit == DatasetFilter::SECONDS && suffix == "h") {
+            factor = 3600;
+        } else if(unit == DatasetFilter::KILOGRAMS && suffix == "kg") {
+            factor = 1;
+        } else {
+            return false;
+        }
+        value += number*factor;
+
+        // only time may be composed: 1h30min
+        if(unit != DatasetFilter::SECONDS && position < text.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Date as YYYY/MM/DD or YYYY-MM-DD.
+ */
+static bool parseDate(const QString& text, double& day)
+{
+    QStringList parts = text.split(text.contains('-') ? '-' : '/');
+    if(parts.size() != 3) {
+        return false;
+    }
+    bool okYear, okMonth, okDay;
+    int year = parts[0].toInt(&okYear);
+    unsigned month = parts[1].toUInt(&okMonth);
+    unsigned dayOfMonth = parts[2].toUInt(&okDay);
+    if(!okYear || !okMonth || !okDay || !Calendar::isValidDate(year, month, dayOfMonth)) {
+        return false;
+    }
+    day = static_cast<double>(Calendar::daysFromCivil(year, month, dayOfMonth));
+    return true;
+}
+
+void DatasetFilter::compile(const QString& expression)
+{
+    vector<Conjunction> compiled{};
+    Conjunction conjunction{};
+    FilterParser parser{expression};
+
+    while(!parser.atEnd()) {
+        QString token = parser.readToken(true);
+        const QString lowerToken = token.toLower();
+        if(lowerToken == "and") {
+            // terms are joined by and anyway
+            continue;
+        }
+        if(lowerToken == "or") {
+            if(conjunction.empty()) {
+                parser.error("Missing term before 'or'");
+            }
+            compiled.push_back(move(conjunction));
+            conjunction.clear();
+            continue;
+        }
+
+        Term term{};
+        if(!parser.atOperator()) {
+            if(token.isEmpty()) {
+                parser.error("Missing field name");
+            }
+            // bare word
+            term.field = &DESCRIPTION_FIELD;
+            term.op = CONTAINS;
+            term.text = token;
+            conjunction.push_back(term);
+            continue;
+        }
+
+        if(!(term.field = findField(token))) {
+            parser.error("Unknown field '" + token.toStdString() + "'");
+        }
+        term.op = parser.readOperator();
+        if(parser.atEnd()) {
+            parser.error("Missing value of '" + token.toStdString() + "'");
+        }
+        term.text = parser.readToken(false);
+
+        const bool textOperator = term.op == CONTAINS || term.op == NOT_CONTAINS;
+        const bool orderOperator = term.op != EQUAL && term.op != NOT_EQUAL && !textOperator;
+        switch(term.field->type) {
+        case YEAR:
+        case UINT:
+        case FLOAT:
+            if(textOperator) {
+                parser.error("Field '" + token.toStdString() + "' is a number - use = != < <= > >=");
+            }
+            if(!parseQuantity(term.text, term.field->unit, term.number)) {
+                parser.error("Invalid number '" + term.text.toStdString() + "'");
+            }
+            if(term.field->type == YEAR && term.number != static_cast<int64_t>(term.number)) {
+                parser.error("Invalid year '" + term.text.toStdString() + "'");
+            }
+            if(term.field->type == FLOAT) {
+                // compared as the stored float
+                term.number = static_cast<float>(term.number);
+            }
+            break;
+        case DATE:
+            if(textOperator) {
+                parser.error("Field 'date' is a date - use = != < <= > >=");
+            }
+            if(!parseDate(term.text, term.number)) {
+                parser.error("Invalid date '" + term.text.toStdString() + "' - use YYYY/MM/DD");
+            }
+            break;
+        case STRING:
+        case CATEGORICAL:
+            if(orderOperator) {
+                parser.error("Field '" + token.toStdString() + "' is a text - use = != ~ !~");
+            }
+            break;
+        }
+        conjunction.push_back(term);
+    }
+    if(!conjunction.empty()) {
+        compiled.push_back(move(conjunction));
+    } else if(!compiled.empty()) {
+        parser.error("Missing term after 'or'");
+    }
+
+    this->expression = expression;
+    conjunctions = move(compiled);
+}
+
+void DatasetFilter::clear()
+{
+    expression.clear();
+    conjunctions.clear();
+}
+
+/*
+ * Selection
+ */
+
+static bool matchText(const QString& value, DatasetFilter::Operator op, const QString& text)
+{
+    switch(op) {
+    case DatasetFilter::EQUAL:
+        return value.compare(text, Qt::CaseInsensitive) == 0;
+    case DatasetFilter::NOT_EQUAL:
+        return value.compare(text, Qt::CaseInsensitive) != 0;
+    case DatasetFilter::CONTAINS:
+        return value.contains(text, Qt::CaseInsensitive);
+    case DatasetFilter::NOT_CONTAINS:
+        return !value.contains(text, Qt::CaseInsensitive);
+    default:
+        return false;
+    }
+}
+
+static bool isAscii(string_view value)
+{
+    return all_of(value.begin(), value.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+static char foldAscii(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c-'A'+'a') : c;
+}
+
+/**
+ * @brief Text term matched on UTF-8 of string column values.
+ *
+ * ASCII value (most of them) w/ ASCII text is matched by case folded bytes,
+ * other values are decoded to a transient QString - string column does not
+ * cache QStrings of rows which are only filtered.
+ */
+class Utf8TextMatcher
+{
+private:
+    DatasetFilter::Operator op;
+    const QString& text;
+    bool asciiText;
+    string foldedText;
+
+    static bool equalFolded(char valueChar, char foldedChar) {
+        return foldAscii(valueChar) == foldedChar;
+    }
+
+    bool matchAscii(string_view value) const {
+        switch(op) {
+        case DatasetFilter::EQUAL:
+        case DatasetFilter::NOT_EQUAL: {
+            const bool equals = value.size() == foldedText.size()
+                && equal(value.begin(), value.end(), foldedText.begin(), equalFolded);
+            return equals == (op == DatasetFilter::EQUAL);
+        }
+        case DatasetFilter::CONTAINS:
+        case DatasetFilter::NOT_CONTAINS: {
+            const bool contains = foldedText.empty()
+                || search(value.begin(), value.end(), foldedText.begin(), foldedText.end(), equalFolded) != value.end();
+            return contains == (op == DatasetFilter::CONTAINS);
+        }
+        default:
+            return false;
+        }
+    }
+
+public:
+    Utf8TextMatcher(DatasetFilter::Operator op, const QString& text)
+        : op(op),
+          text(text),
+          asciiText(false),
+          foldedText()
+    {
+        const QByteArray utf8 = text.toUtf8();
+        foldedText.assign(utf8.constData(), static_cast<size_t>(utf8.size()));
+        asciiText = isAscii(foldedText);
+        transform(foldedText.begin(), foldedText.end(), foldedText.begin(), foldAscii);
+    }
+
+    bool operator()(string_view value) const {
+        if(asciiText && isAscii(value)) {
+            return matchAscii(value);
+        }
+        return matchText(QString::fromUtf8(value.data(), static_cast<int>(value.size())), op, text);
+    }
+};
+
+/**
+ * @brief Operator is dispatched once per term, not per row.
+ */
+template<class Key, class Filter>
+static void filterNumbers(Key key, DatasetFilter::Operator op, double value, Filter filter)
+{
+    switch(op) {
+    case DatasetFilter::EQUAL:
+        filter([&](unsigned row) { return key(row) == value; });
+        break;
+    case DatasetFilter::NOT_EQUAL:
+        filter([&](unsigned row) { return key(row) != value; });
+        break;
+    case DatasetFilter::LESS:
+        filter([&](unsigned row) { return key(row) < value; });
+        break;
+    case DatasetFilter::LESS_EQUAL:
+        filter([&](unsigned row) { return key(row) <= value; });
+        break;
+    case DatasetFilter::GREATER:
+        filter([&](unsigned row) { return key(row) > value; });
+        break;
+    case DatasetFilter::GREATER_EQUAL:
+        filter([&](unsigned row) { return key(row) >= value; });
+        break;
+    default:
+        filter([](unsigned) { return false; });
+    }
+}
+
+static int32_t clampDay(int64_t day)
+{
+    return static_cast<int32_t>(max<int64_t>(INT32_MIN+1, min<int64_t>(INT32_MAX, day)));
+}
+
+void DatasetFilter::selectConjunction(const Dataset& dataset, const Conjunction& conjunction, vector<unsigned>& rows) const
+{
+    const DatasetColumns& columns = dataset.getColumns();
+    const DateIndex& dateIndex = dataset.getDateIndex();
+
+    // year and date terms narrow the range of the date index
+    bool dated = false;
+    int64_t firstDay = INT32_MIN+1;
+    int64_t lastDay = INT32_MAX;
+    vector<const Term*> terms{};
+    for(const Term& term:conjunction) {
+        const FieldType type = term.field->type;
+        if(type != YEAR && type != DATE) {
+            terms.push_back(&term);
+            continue;
+        }
+        dated = true;
+        if(term.op == NOT_EQUAL) {
+            terms.push_back(&term);
+            continue;
+        }
+        int64_t first, last;
+        if(type == YEAR) {
+            const int64_t year = static_cast<int64_t>(term.number);
+            first = Calendar::daysFromCivil(year, 1, 1);
+            last = Calendar::daysFromCivil(year, 12, 31);
+        } else {
+            first = last = static_cast<int64_t>(term.number);
+        }
+        switch(term.op) {
+        case EQUAL:
+            firstDay = max(firstDay, first);
+            lastDay = min(lastDay, last);
+            break;
+        case LESS:
+            lastDay = min(lastDay, first-1);
+            break;
+        case LESS_EQUAL:
+            lastDay = min(lastDay, last);
+            break;
+        case GREATER:
+            firstDay = max(firstDay, last+1);
+            break;
+        case GREATER_EQUAL:
+            firstDay = max(firstDay, first);
+            break;
+        default:
+            break;
+        }
+    }
+
+    rows.clear();
+    bool selected = false;
+    if(dated) {
+        DateIndex::Range range = dateIndex.getRange(clampDay(firstDay), clampDay(lastDay));
+        rows.reserve(range.size());
+        for(const DateIndex::Entry& entry:range) {
+            rows.push_back(static_cast<unsigned>(entry.instance->getRow()));
+        }
+        // index is sorted by date, selection by row
+        sort(rows.begin(), rows.end());
+        selected = true;
+    }
+
+    // the first term scans the column, others filter the selection
+    const unsigned size = static_cast<unsigned>(columns.size());
+    auto filter = [&rows, &selected, size](auto predicate) {
+        if(!selected) {
+            for(unsigned row=0; row<size; row++) {
+                if(predicate(row)) {
+                    rows.push_back(row);
+                }
+            }
+            selected = true;
+        } else {
+            size_t kept = 0;
+            for(size_t i=0; i<rows.size(); i++) {
+                if(predicate(rows[i])) {
+                    rows[kept++] = rows[i];
+                }
+            }
+            rows.resize(kept);
+        }
+    };
+
+    for(const Term* term:terms) {
+        if(selected && rows.empty()) {
+            return;
+        }
+        const int column = term->field->column;
+        switch(term->field->type) {
+        case YEAR: {
+            const vector<unsigned>& years = columns.getColumn(DatasetColumns::YEAR);
+            filterNumbers([&years](unsigned row) { return static_cast<double>(years[row]); }, term->op, term->number, filter);
+            break;
+        }
+        case DATE:
+            filterNumbers([&dateIndex](unsigned row) { return static_cast<double>(dateIndex.getRowDay(row)); }, term->op, term->number, filter);
+            break;
+        case UINT: {
+            const vector<unsigned>& values = columns.getColumn(static_cast<DatasetColumns::UIntColumn>(column));
+            filterNumbers([&values](unsigned row) { return static_cast<double>(values[row]); }, term->op, term->number, filter);
+            break;
+        }
+        case FLOAT: {
+            const vector<float>& values = columns.getColumn(static_cast<DatasetColumns::FloatColumn>(column));
+            filterNumbers([&values](unsigned row) { return static_cast<double>(values[row]); }, term->op, term->number, filter);
+            break;
+        }
+        case STRING: {
+            const Utf8Column& values = columns.getColumn(static_cast<DatasetColumns::StringColumn>(column));
+            const Utf8TextMatcher matcher{term->op, term->text};
+            filter([&values, &matcher](unsigned row) { return matcher(values.getUtf8(row)); });
+            break;
+        }
+        case CATEGORICAL: {
+            // values are matched once per code, rows by code
+            const DatasetColumns::CategoricalColumn c = static_cast<DatasetColumns::CategoricalColumn>(column);
+            const CategoricalFeature& feature = columns.getFeature(c);
+            vector<unsigned char> matches(feature.size());
+            for(unsigned code=0; code<feature.size(); code++) {
+                matches[code] = matchText(feature.getValue(code), term->op, term->text);
+            }
+            const vector<unsigned>& codes = columns.getColumn(c);
+            filter([&codes, &matches](unsigned row) { return matches[codes[row]] != 0; });
+            break;
+        }
+        }
+    }
+}
+
+void DatasetFilter::select(const Dataset& dataset, vector<unsigned>& rows) const
+{
+    rows.clear();
+    if(conjunctions.empty()) {
+        rows.resize(dataset.getColumns().size());
+        iota(rows.begin(), rows.end(), 0);
+        return;
+    }
+
+    selectConjunction(dataset, conjunctions[0], rows);
+    if(conjunctions.size() > 1) {
+        vector<unsigned> conjunctionRows{};
+        vector<unsigned> merged{};
+        for(size_t i=1; i<conjunctions.size(); i++) {
+            selectConjunction(dataset, conjunctions[i], conjunctionRows);
+            merged.clear();
+            set_union(rows.begin(), rows.end(), conjunctionRows.begin(), conjunctionRows.end(), back_inserter(merged));
+            rows.swap(merged);
+        }
+    }
+}
+
+} // namespace etl76
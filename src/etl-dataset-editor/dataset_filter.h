@@ -0,0 +1,135 @@
+/*
+ dataset_filter.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_FILTER_H
+#define ETL76_DATASET_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "dataset.h"
+#include "exceptions.h"
+
+namespace etl76 {
+
+/**
+ * @brief Dataset filter.
+ *
+ * Filter expression is a sequence of terms joined by and/or (and binds
+ * tighter), for instance:
+ *
+ *   activity=ride and year>=2015 and distance>50km and gear~29er
+ *
+ * Term is field, operator and value: = != < <= > >= and ~ !~ (contains,
+ * case insensitive). Values may be quoted, distance values may have m/km,
+ * time values s/min/h (1h30min), weight kg units. Bare word matches
+ * description.
+ *
+ * Expression is compiled to terms once. Selection binds terms to the
+ * columns (categorical values are matched once per dictionary code)
+ * and filters a selection vector of row ids column by column.
+ * Year and date terms are answered by the date index - rows w/o valid
+ * date don't match them.
+ */
+class DatasetFilter
+{
+public:
+    enum Operator {
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        CONTAINS,
+        NOT_CONTAINS
+    };
+
+    enum FieldType {
+        YEAR,
+        DATE,
+        UINT,
+        FLOAT,
+        STRING,
+        CATEGORICAL
+    };
+
+    enum Unit {
+        NO_UNIT,
+        METERS,
+        SECONDS,
+        KILOGRAMS,
+        BOOLEAN
+    };
+
+    struct Field {
+        const char* name;
+        FieldType type;
+        // column enum of the type
+        int column;
+        Unit unit;
+    };
+
+    struct Term {
+        const Field* field;
+        Operator op;
+        QString text;
+        // number (unit converted) or day number of a date
+        double number;
+    };
+
+    // terms joined by and
+    typedef std::vector<Term> Conjunction;
+
+private:
+    QString expression;
+    // conjunctions joined by or - no conjunction is no filter
+    std::vector<Conjunction> conjunctions;
+
+    void selectConjunction(const Dataset& dataset, const Conjunction& conjunction, std::vector<unsigned>& rows) const;
+
+public:
+    DatasetFilter();
+    DatasetFilter(const DatasetFilter&) = delete;
+    DatasetFilter(const DatasetFilter&&) = delete;
+    DatasetFilter &operator=(const DatasetFilter&) = delete;
+    DatasetFilter &operator=(const DatasetFilter&&) = delete;
+
+    /**
+     * @brief Compile the expression - filter is not changed if the expression is not valid.
+     *
+     * @throws EtlUserException w/ description of the syntax error.
+     */
+    void compile(const QString& expression);
+    void clear();
+
+    bool isEmpty() const { return conjunctions.empty(); }
+    const QString& getExpression() const { return expression; }
+
+    /**
+     * @brief Rows matching the filter in dataset order (all rows if empty).
+     */
+    void select(const Dataset& dataset, std::vector<unsigned>& rows) const;
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_FILTER_H
@@ -18,6 +18,10 @@
 */
 #include "dataset_instance.h"
 
+#include <charconv>
+
+#include "dataset_csv_writer.h"
+
 
 namespace etl76 {
 
@@ -156,6 +160,12 @@ unsigned DatasetInstance::strGToG(QString strG, const string& field)
     }
 }
 
+QString DatasetInstance::floatToStr(float value)
+{
+    char buffer[32];
+    return QString::fromLatin1(buffer, static_cast<int>(to_chars(buffer, buffer+sizeof(buffer), value).ptr - buffer));
+}
+
 /*
  * methods
  */
@@ -164,10 +174,10 @@ DatasetInstance::DatasetInstance(
         unsigned year,
         unsigned month,
         unsigned day,
-        QString when,
+        const QString& when,
         unsigned phase,
-        CategoricalValue activity,
-        QString description,
+        const QString& activity,
+        const QString& description,
         bool commute,
         unsigned totalTimeSeconds,
         unsigned totalDistanceMeters,
@@ -175,7 +185,7 @@ DatasetInstance::DatasetInstance(
         unsigned warmUpDistanceMeters,
         unsigned timeSeconds,
         unsigned distanceMeters,
-        CategoricalValue intensity,
+        const QString& intensity,
         unsigned squats,
         unsigned pushUps,
         unsigned crunches,
@@ -187,171 +197,129 @@ DatasetInstance::DatasetInstance(
         unsigned elevationGain,
         unsigned avgWatts,
         unsigned maxWatts,
-        CategoricalValue gear,
-        CategoricalValue route,
-        QString url,
+        const QString& gear,
+        const QString& route,
+        const QString& url,
         unsigned kcal,
         unsigned coolDownTimeSeconds,
         unsigned coolDownDistanceMeters,
         float weight,
-        CategoricalValue weather,
+        const QString& weather,
         unsigned weatherTemperature,
-        QString where,
+        const QString& where,
         float bmi,
         unsigned gramsOfFatBurn,
-        CategoricalValue source
+        const QString& source
 ):
-    year(year),
-    month(month),
-    day(day),
-    when(when),
-    phase(phase),
-    activity(activity),
-    description(description),
-    commute(commute),
-    totalTimeSeconds(totalTimeSeconds),
-    totalDistanceMeters(totalDistanceMeters),
-    warmUpTimeSeconds(warmUpTimeSeconds),
-    warmUpDistanceMeters(warmUpDistanceMeters),
-    timeSeconds(timeSeconds),
-    distanceMeters(distanceMeters),
-    intensity(intensity),
-    squats(squats),
-    pushUps(pushUps),
-    crunches(crunches),
-    turtles(turtles),
-    calfs(calfs),
-    repetitions(repetitions),
-    avgSpeed(avgSpeed),
-    maxSpeed(maxSpeed),
-    elevationGain(elevationGain),
-    avgWatts(avgWatts),
-    maxWatts(maxWatts),
-    gear(gear),
-    route(route),
-    url(url),
-    kcal(kcal),
-    coolDownTimeSeconds(coolDownTimeSeconds),
-    coolDownDistanceMeters(coolDownDistanceMeters),
-    weight(weight),
-    weather(weather),
-    weatherTemperature(weatherTemperature),
-    where(where),
-    bmi(bmi),
-    gramsOfFatBurnt(gramsOfFatBurn),
-    source(source)
+    detachedColumns(new DatasetColumns{})
+{
+    columns = detachedColumns.get();
+    row = 0;
+    datasetIndex = 0;
+
+    columns->appendRow(
+        year,
+        month,
+        day,
+        when,
+        phase,
+        columns->getFeature(DatasetColumns::ACTIVITY).intern(activity),
+        description,
+        commute,
+        totalTimeSeconds,
+        totalDistanceMeters,
+        warmUpTimeSeconds,
+        warmUpDistanceMeters,
+        timeSeconds,
+        distanceMeters,
+        columns->getFeature(DatasetColumns::INTENSITY).intern(intensity),
+        squats,
+        pushUps,
+        crunches,
+        turtles,
+        calfs,
+        repetitions,
+        avgSpeed,
+        maxSpeed,
+        elevationGain,
+        avgWatts,
+        maxWatts,
+        columns->getFeature(DatasetColumns::GEAR).intern(gear),
+        columns->getFeature(DatasetColumns::ROUTE).intern(route),
+        url,
+        kcal,
+        coolDownTimeSeconds,
+        coolDownDistanceMeters,
+        weight,
+        columns->getFeature(DatasetColumns::WEATHER).intern(weather),
+        weatherTemperature,
+        where,
+        bmi,
+        gramsOfFatBurn,
+        columns->getFeature(DatasetColumns::SOURCE).intern(source)
+    );
+}
+
+DatasetInstance::DatasetInstance(DatasetColumns* columns, size_t row):
+    columns(columns),
+    row(row),
+    datasetIndex(static_cast<int>(row))
 {
-    cout << toString();
 }
 
-string DatasetInstance::toString()
+string DatasetInstance::toString() const
 {
     stringstream os{};
     os << "New dataset instance:" << endl
-    << "  Year: " << year << endl
-    << "  Month: " << month << endl
-    << "  Day: " << day << endl
-    << "  When: " << when.toStdString() << endl
-    << "  Phase: " << phase << endl
-    << "  Activity: " << activity.toString().toStdString() << endl
-    << "  Description: " << description.toStdString() << endl
-    << "  Commute: " << commute << endl
-    << "  Total time: " << totalTimeSeconds << endl
-    << "  Total meters: " << totalDistanceMeters << endl
-    << "  Warm time: " << warmUpTimeSeconds << endl
-    << "  Warm meters: " << warmUpDistanceMeters << endl
-    << "  Time: " << timeSeconds << endl
-    << "  Meters: " << distanceMeters << endl
-    << "  Intensity: " << intensity.toString().toStdString() << endl
-    << "  Squats: " << squats << endl
-    << "  Push ups: " << pushUps << endl
-    << "  Crunches: " << crunches << endl
-    << "  Turtles: " << turtles << endl
-    << "  Calfs: " << calfs << endl
-    << "  Repetitions: " << repetitions << endl
-    << "  Avg speed: " << avgSpeed << endl
-    << "  Max speed: " << maxSpeed << endl
-    << "  Elevation gain: " << elevationGain << endl
-    << "  Avg watts: " << avgWatts << endl
-    << "  Max watts: " << maxWatts << endl
-    << "  Gear: " << gear.toString().toStdString() << endl
-    << "  Route: " << route.toString().toStdString() << endl
-    << "  URL: " << url.toStdString() << endl
-    << "  kcal: " << kcal << endl
-    << "  Cool time: " << coolDownTimeSeconds << endl
-    << "  Cool meters: " << coolDownDistanceMeters << endl
-    << "  Weight: " << weight << endl
-    << "  Weather: " << weather.toString().toStdString() << endl
-    << "  Temperature: " << weatherTemperature << endl
-    << "  Where: " << where.toStdString() << endl
-    << "  BMI: " << bmi << endl
-    << "  Fat: " << gramsOfFatBurnt << endl
-    << "  Source: " << source.toString().toStdString() << endl;
+    << "  Year: " << getYear() << endl
+    << "  Month: " << getMonth() << endl
+    << "  Day: " << getDay() << endl
+    << "  When: " << getWhen().toStdString() << endl
+    << "  Phase: " << getPhase() << endl
+    << "  Activity: " << getActivity().toString().toStdString() << endl
+    << "  Description: " << getDescription().toStdString() << endl
+    << "  Commute: " << getCommute() << endl
+    << "  Total time: " << getTotalTimeSeconds() << endl
+    << "  Total meters: " << getTotalDistanceMeters() << endl
+    << "  Warm time: " << getWarmUpSeconds() << endl
+    << "  Warm meters: " << getWarmUpDistanceMeters() << endl
+    << "  Time: " << getTimeSeconds() << endl
+    << "  Meters: " << getDistanceMeters() << endl
+    << "  Intensity: " << getIntensity().toString().toStdString() << endl
+    << "  Squats: " << getSquats() << endl
+    << "  Push ups: " << getPushUps() << endl
+    << "  Crunches: " << getCrunches() << endl
+    << "  Turtles: " << getTurles() << endl
+    << "  Calfs: " << getCalfs() << endl
+    << "  Repetitions: " << getRepetitions() << endl
+    << "  Avg speed: " << columns->get(DatasetColumns::AVG_SPEED, row) << endl
+    << "  Max speed: " << columns->get(DatasetColumns::MAX_SPEED, row) << endl
+    << "  Elevation gain: " << getElevationGain() << endl
+    << "  Avg watts: " << getAvgWatts() << endl
+    << "  Max watts: " << getMaxWatts() << endl
+    << "  Gear: " << getGear().toString().toStdString() << endl
+    << "  Route: " << getRoute().toString().toStdString() << endl
+    << "  URL: " << getUrl().toStdString() << endl
+    << "  kcal: " << getKcal() << endl
+    << "  Cool time: " << getCoolDownTimeSeconds() << endl
+    << "  Cool meters: " << getCoolDownDistanceMeters() << endl
+    << "  Weight: " << getWeight() << endl
+    << "  Weather: " << getWeather().toString().toStdString() << endl
+    << "  Temperature: " << getWeatherTemperature() << endl
+    << "  Where: " << getWhere().toStdString() << endl
+    << "  BMI: " << getBmi() << endl
+    << "  Fat: " << getGramsOfFatBurnt() << endl
+    << "  Source: " << getSource().toString().toStdString() << endl;
 
 
     return os.str();
 }
 
-string quoteCsvString(const string& s)
+string DatasetInstance::toCsv() const
 {
-    string quoted{s}, quote{"\""};
-    if(s.length()) {
-        if(s[0] != quote[0]) {
-            size_t found = quoted.find(',');
-            if (found != string::npos) {
-                quoted.insert(0, quote);
-                quoted.append(quote);
-            }
-        }
-    }
-    return quoted;
-}
-
-string DatasetInstance::toCsv()
-{
-    stringstream os{};
-    os
-    << year << ", "
-    << month << ", "
-    << day << ", "
-    << quoteCsvString(when.toStdString()) << ", "
-    << phase << ", "
-    << quoteCsvString(activity.toString().toStdString()) << ", "
-    << quoteCsvString(description.toStdString()) << ", "
-    << commute << ", "
-    << totalTimeSeconds << ", "
-    << totalDistanceMeters << ", "
-    << warmUpTimeSeconds << ", "
-    << warmUpDistanceMeters << ", "
-    << timeSeconds << ", "
-    << distanceMeters << ", "
-    << quoteCsvString(intensity.toString().toStdString()) << ", "
-    << squats << ", "
-    << pushUps << ", "
-    << crunches << ", "
-    << turtles << ", "
-    << calfs << ", "
-    << repetitions << ", "
-    << avgSpeed << ", "
-    << maxSpeed << ", "
-    << elevationGain << ", "
-    << avgWatts << ", "
-    << maxWatts << ", "
-    << quoteCsvString(gear.toString().toStdString()) << ", "
-    << quoteCsvString(route.toString().toStdString()) << ", "
-    << quoteCsvString(url.toStdString()) << ", "
-    << kcal << ", "
-    << coolDownTimeSeconds << ", "
-    << coolDownDistanceMeters << ", "
-    << weight << ", "
-    << quoteCsvString(weather.toString().toStdString()) << ", "
-    << weatherTemperature << ", "
-    << quoteCsvString(where.toStdString()) << ", "
-    << bmi << ", "
-    << gramsOfFatBurnt << ", "
-    << quoteCsvString(source.toString().toStdString()) << endl;
-
-    return os.str();
+    DatasetCsvWriter writer{};
+    writer.appendRow(*columns, row);
+    return string{writer.data(), writer.size()};
 }
 
 } // etl76 namespace
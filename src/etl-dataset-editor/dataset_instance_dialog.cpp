@@ -339,8 +339,8 @@ void DatasetInstanceDialog::fromInstance(DatasetInstance* instance)
     turtlesEdit->setText(QString::number(instance->getTurles()));
     calfsEdit->setText(QString::number(instance->getCalfs()));
     repetitionsEdit->setText(QString::number(instance->getRepetitions()));
-    avgSpeedEdit->setText(QString::number(instance->getAvgSpeed()));
-    maxSpeedEdit->setText(QString::number(instance->getMaxSpeed()));
+    avgSpeedEdit->setText(DatasetInstance::floatToStr(instance->getAvgSpeed()));
+    maxSpeedEdit->setText(DatasetInstance::floatToStr(instance->getMaxSpeed()));
     elevationGainEdit->setText(QString::number(instance->getElevationGain()));
     avgWattsEdit->setText(QString::number(instance->getAvgWatts()));
     maxWattsEdit->setText(QString::number(instance->getMaxWatts()));
@@ -354,7 +354,7 @@ void DatasetInstanceDialog::fromInstance(DatasetInstance* instance)
     weatherEdit->setText(instance->getWeather().toString());
     weatherTemperatureEdit->setText(QString::number(instance->getWeatherTemperature()));
     whereEdit->setText(instance->getWhere());
-    bmiEdit->setText(QString::number(instance->getBmi()));
+    bmiEdit->setText(DatasetInstance::floatToStr(instance->getBmi()));
     gramsOfFatBurntEdit->setText(instance->getGramsOfFatBurntStr());
     sourceEdit->setText(instance->getSource().toString());
 }
@@ -370,7 +370,7 @@ DatasetInstance* DatasetInstanceDialog::toDatasetInstance()
         DatasetInstance::ymdToDay(yearMonthDayEdit->text(), "Day"),
         whenEdit->text(),
         phaseEdit->text().toUInt(),
-        CategoricalValue(activityEdit->text()),
+        activityEdit->text(),
         descriptionEdit->text(),
         commuteCheck->isChecked(),
         DatasetInstance::strTimeToSeconds(totalTimeEdit->text(), "Total time"),
@@ -379,7 +379,7 @@ DatasetInstance* DatasetInstanceDialog::toDatasetInstance()
         DatasetInstance::strMetersToMeters(warmUpDistanceEdit->text(), "Warm-up distance"),
         DatasetInstance::strTimeToSeconds(timeEdit->text(), "Time"),
         DatasetInstance::strMetersToMeters(distanceEdit->text(), "Distance"),
-        CategoricalValue(intensityEdit->text()),
+        intensityEdit->text(),
         squatsEdit->text().toUInt(),
         pushUpsEdit->text().toUInt(),
         crunchesEdit->text().toUInt(),
@@ -391,19 +391,19 @@ DatasetInstance* DatasetInstanceDialog::toDatasetInstance()
         elevationGainEdit->text().toUInt(),
         avgWattsEdit->text().toUInt(),
         maxWattsEdit->text().toUInt(),
-        CategoricalValue(gearEdit->text()),
-        CategoricalValue(routeEdit->text()),
+        gearEdit->text(),
+        routeEdit->text(),
         QString(urlEdit->text()),
         kcalEdit->text().toUInt(),
         DatasetInstance::strTimeToSeconds(coolDownTimeEdit->text(), "Cool-down time"),
         DatasetInstance::strMetersToMeters(coolDownDistanceEdit->text(), "Cool-down distance"),
         DatasetInstance::strKgToKg(weightEdit->text(), "Weight"),
-        CategoricalValue(weatherEdit->text()),
+        weatherEdit->text(),
         weatherTemperatureEdit->text().toUInt(),
         whereEdit->text(),
         bmiEdit->text().toFloat(),
         DatasetInstance::strGToG(gramsOfFatBurntEdit->text(), "Grams of fat burnt"),
-        CategoricalValue(sourceEdit->text())
+        sourceEdit->text()
     };
 
     // TODO instance->validate();
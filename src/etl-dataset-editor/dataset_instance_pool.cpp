@@ -0,0 +1,70 @@
+/*
+ dataset_instance_pool.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_instance_pool.h"
+
+#include <new>
+
+namespace etl76 {
+
+using namespace std;
+
+DatasetInstancePool::DatasetInstancePool()
+    : slabUsed(SLAB_SIZE),
+      freeSlots(nullptr),
+      instances(0)
+{
+}
+
+DatasetInstance* DatasetInstancePool::create(DatasetColumns* columns, size_t row)
+{
+    Slot* slot;
+    if(freeSlots) {
+        slot = freeSlots;
+        freeSlots = slot->next;
+    } else {
+        if(slabUsed == SLAB_SIZE) {
+            slabs.push_back(unique_ptr<Slot[]>(new Slot[SLAB_SIZE]));
+            slabUsed = 0;
+        }
+        slot = &slabs.back()[slabUsed++];
+    }
+
+    instances++;
+    return new(slot->instance) DatasetInstance{columns, row};
+}
+
+void DatasetInstancePool::destroy(DatasetInstance* instance)
+{
+    instance->~DatasetInstance();
+
+    Slot* slot = reinterpret_cast<Slot*>(instance);
+    slot->next = freeSlots;
+    freeSlots = slot;
+    instances--;
+}
+
+void DatasetInstancePool::clear()
+{
+    slabs.clear();
+    slabUsed = SLAB_SIZE;
+    freeSlots = nullptr;
+    instances = 0;
+}
+
+} // namespace etl76
@@ -0,0 +1,70 @@
+/*
+ dataset_instance_pool.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_INSTANCE_POOL_H
+#define ETL76_DATASET_INSTANCE_POOL_H
+
+#include <memory>
+#include <vector>
+
+#include "dataset_instance.h"
+
+namespace etl76 {
+
+/**
+ * @brief Slab allocator of dataset instances.
+ *
+ * Dataset instances (row views) are allocated in slabs of adjacent slots,
+ * slots of destroyed instances are reused. The whole pool is freed at once
+ * on clear() w/o visiting the instances - it is safe as pooled instances
+ * are always views of dataset columns (they own no detached columns).
+ */
+class DatasetInstancePool
+{
+private:
+    static const size_t SLAB_SIZE = 4096;
+
+    union Slot {
+        Slot* next;
+        alignas(DatasetInstance) unsigned char instance[sizeof(DatasetInstance)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    // slots used in the last slab
+    size_t slabUsed;
+    Slot* freeSlots;
+    size_t instances;
+
+public:
+    DatasetInstancePool();
+    DatasetInstancePool(const DatasetInstancePool&) = delete;
+    DatasetInstancePool(const DatasetInstancePool&&) = delete;
+    DatasetInstancePool &operator=(const DatasetInstancePool&) = delete;
+    DatasetInstancePool &operator=(const DatasetInstancePool&&) = delete;
+
+    DatasetInstance* create(DatasetColumns* columns, size_t row);
+    void destroy(DatasetInstance* instance);
+    void clear();
+
+    size_t size() const { return instances; }
+    size_t getByteSize() const { return slabs.size()*SLAB_SIZE*sizeof(Slot); }
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_INSTANCE_POOL_H
@@ -0,0 +1,385 @@
+/*
+ dataset_journal.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_journal.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset_snapshot.h"
+#include "mapped_file.h"
+
+namespace etl76 {
+
+using namespace std;
+
+static const string JOURNAL_MAGIC{"etl-journal"};
+
+DatasetJournal::DatasetJournal()
+    : filePath(),
+      fd(-1),
+      records(0)
+{
+}
+
+DatasetJournal::~DatasetJournal()
+{
+    close();
+}
+
+string DatasetJournal::journalPath(const string& csvFilePath)
+{
+    return DatasetSnapshot::siblingPath(csvFilePath, FILE_EXTENSION);
+}
+
+/*
+ * CSV file is identified by its size and modification time: compaction
+ * rewrites the CSV and so makes its previous journal stale.
+ */
+bool DatasetJournal::getCsvFileId(const string& csvFilePath, string& id)
+{
+    struct stat csvStat;
+    if(stat(csvFilePath.c_str(), &csvStat) != 0) {
+        return false;
+    }
+    id = JOURNAL_MAGIC
+        + " " + to_string(VERSION)
+        + " " + to_string(csvStat.st_size)
+        + " " + to_string(csvStat.st_mtim.tv_sec)
+        + " " + to_string(csvStat.st_mtim.tv_nsec);
+    return true;
+}
+
+/*
+ * Record ends w/ a newline outside of quoted field (row description may
+ * be quoted), nullptr is returned for incomplete record.
+ */
+static const char* findRecordEnd(const char* begin, const char* end)
+{
+    bool quoted = false;
+    for(const char* c = begin; c != end; ++c) {
+        if(*c == '"') {
+            quoted = !quoted;
+        } else if(*c == '\n' && !quoted) {
+            return c;
+        }
+    }
+    return nullptr;
+}
+
+static const char* parseIndex(const char* begin, const char* end, size_t& index)
+{
+    if(begin == end || *begin != ' ') {
+        return nullptr;
+    }
+    from_chars_result result = from_chars(begin+1, end, index);
+    if(result.ec != errc{}) {
+        return nullptr;
+    }
+    return result.ptr;
+}
+
+static bool writeRecord(int fd, const string& record)
+{
+    // single write of a small record: it is either appended whole or it
+    // is incomplete and ignored on replay
+    const char* data = record.data();
+    size_t remaining = record.size();
+    while(remaining) {
+        ssize_t written = ::write(fd, data, remaining);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/*
+ * Compaction marker is "C <offset> <CSV file id>": records before the offset
+ * are in the CSV file w/ the id.
+ */
+static bool parseCompactionMarker(const char* record, const char* recordEnd, const string& csvId, size_t& offset)
+{
+    if(record == recordEnd || static_cast<DatasetJournal::Operation>(*record) != DatasetJournal::Operation::COMPACTION) {
+        return false;
+    }
+    const char* c = parseIndex(record+1, recordEnd, offset);
+    return c && c != recordEnd && *c == ' '
+        && csvId.compare(0, string::npos, c+1, recordEnd-c-1) == 0;
+}
+
+size_t DatasetJournal::read(
+        const string& csvFilePath,
+        vector<Record>& records,
+        string& rowsCsv)
+{
+    string csvId;
+    string filePath{journalPath(csvFilePath)};
+    struct stat journalStat;
+    if(!getCsvFileId(csvFilePath, csvId) || stat(filePath.c_str(), &journalStat) != 0) {
+        return 0;
+    }
+
+    MappedFile journalFile{filePath};
+    const char* begin = journalFile.begin();
+    const char* end = journalFile.end();
+
+    const char* headerEnd = begin ? static_cast<const char*>(memchr(begin, '\n', end-begin)) : nullptr;
+    if(!headerEnd) {
+        return 0;
+    }
+    const char* record = headerEnd+1;
+    if(csvId.compare(0, string::npos, begin, headerEnd-begin) != 0) {
+        // journal of previous version of the CSV file: it is stale unless
+        // the CSV was written by compaction which did not rebase the journal
+        const char* replayFrom = nullptr;
+        for(const char* r = record, *rEnd; r != end && (rEnd = findRecordEnd(r, end)); r = rEnd+1) {
+            size_t offset;
+            if(parseCompactionMarker(r, rEnd, csvId, offset) && offset <= journalFile.getSize()) {
+                replayFrom = begin+offset;
+            }
+        }
+        if(!replayFrom) {
+            return 0;
+        }
+        record = max(record, replayFrom);
+    }
+
+    size_t rows = 0;
+    while(record != end) {
+        const char* recordEnd = findRecordEnd(record, end);
+        if(!recordEnd) {
+            cerr << "Incomplete record at the end of journal " << filePath << " ignored" << endl;
+            break;
+        }
+        if(record == recordEnd) {
+            // empty line has no operation
+            cerr << "Invalid record in journal " << filePath << " - journal is replayed up to it" << endl;
+            break;
+        }
+
+        Record r{static_cast<Operation>(*record), 0, 0, 0};
+        const char* c = parseIndex(record+1, recordEnd, r.index);
+        switch(r.operation) {
+        case Operation::INSERT:
+        case Operation::SET:
+            if(c && c != recordEnd && *c == ' ') {
+                rowsCsv.append(c+1, recordEnd+1);
+                r.argument = rows++;
+            } else {
+                c = nullptr;
+            }
+            break;
+        case Operation::SWITCH:
+            if(c) {
+                c = parseIndex(c, recordEnd, r.argument);
+            }
+            break;
+        case Operation::REMOVE:
+            break;
+        case Operation::COMPACTION:
+            // marker is not an edit
+            record = recordEnd+1;
+            continue;
+        default:
+            c = nullptr;
+        }
+        if(!c || (r.operation != Operation::INSERT && r.operation != Operation::SET && c != recordEnd)) {
+            cerr << "Invalid record in journal " << filePath << " - journal is replayed up to it" << endl;
+            break;
+        }
+
+        record = recordEnd+1;
+        r.end = static_cast<size_t>(record-begin);
+        records.push_back(r);
+    }
+
+    return static_cast<size_t>(record-begin);
+}
+
+void DatasetJournal::markCompaction(
+        const string& csvFilePath,
+        const string& newCsvFilePath,
+        size_t offset)
+{
+    string newCsvId;
+    string filePath{journalPath(csvFilePath)};
+    if(offset == NO_OFFSET || !getCsvFileId(newCsvFilePath, newCsvId)) {
+        return;
+    }
+
+    int markerFd = ::open(filePath.c_str(), O_WRONLY|O_APPEND);
+    if(markerFd < 0) {
+        // no journal, nothing to mark
+        return;
+    }
+    string marker{static_cast<char>(Operation::COMPACTION)};
+    marker += " " + to_string(offset) + " " + newCsvId + "\n";
+    // marker must be durable before the new CSV replaces the old one
+    bool written = writeRecord(markerFd, marker) && fsync(markerFd) == 0;
+    int error = errno;
+    ::close(markerFd);
+    if(!written) {
+        throw EtlRuntimeException(
+            "Unable to write compaction marker to journal "+filePath+": "+strerror(error)
+        );
+    }
+}
+
+void DatasetJournal::rebase(const string& csvFilePath, size_t offset)
+{
+    string csvId;
+    if(offset == NO_OFFSET || !isOpen() || !getCsvFileId(csvFilePath, csvId)) {
+        open(csvFilePath, 0, 0);
+        return;
+    }
+
+    // records appended since the compaction started are kept
+    string journal{csvId+"\n"};
+    size_t tailRecords = 0;
+    try {
+        MappedFile journalFile{filePath};
+        const char* end = journalFile.end();
+        const char* record = journalFile.begin()+min(offset, journalFile.getSize());
+        for(const char* recordEnd; record != end && (recordEnd = findRecordEnd(record, end)); record = recordEnd+1) {
+            if(static_cast<Operation>(*record) != Operation::COMPACTION) {
+                journal.append(record, recordEnd+1);
+                tailRecords++;
+            }
+        }
+    } catch(EtlRuntimeException& e) {
+        // journal w/ compaction marker stays valid
+        cerr << e.what() << endl;
+        return;
+    }
+
+    string tmpFilePath{filePath+".tmp"};
+    int tmpFd = ::open(tmpFilePath.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    bool written = tmpFd >= 0 && writeRecord(tmpFd, journal) && fsync(tmpFd) == 0;
+    if(tmpFd >= 0) {
+        written = ::close(tmpFd) == 0 && written;
+    }
+    if(!written || rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+        cerr << "Unable to rebase journal " << filePath << ": " << strerror(errno) << endl;
+        remove(tmpFilePath.c_str());
+        return;
+    }
+
+    close();
+    open(csvFilePath, journal.size(), tailRecords);
+}
+
+void DatasetJournal::open(const string& csvFilePath, size_t validSize, size_t validRecords)
+{
+    close();
+
+    string csvId;
+    if(!getCsvFileId(csvFilePath, csvId)) {
+        // journal is started once the CSV is written
+        return;
+    }
+
+    filePath = journalPath(csvFilePath);
+    fd = ::open(filePath.c_str(), O_WRONLY|O_CREAT|O_APPEND, 0644);
+    if(fd < 0) {
+        cerr << "Unable to open journal " << filePath << ": " << strerror(errno) << endl;
+        return;
+    }
+    if(ftruncate(fd, static_cast<off_t>(validSize)) != 0) {
+        cerr << "Unable to truncate journal " << filePath << ": " << strerror(errno) << endl;
+        close();
+        return;
+    }
+
+    records = validRecords;
+    if(!validSize) {
+        string header{csvId+"\n"};
+        if(::write(fd, header.data(), header.size()) != static_cast<ssize_t>(header.size())) {
+            cerr << "Unable to write journal " << filePath << ": " << strerror(errno) << endl;
+            close();
+            return;
+        }
+    }
+}
+
+void DatasetJournal::close()
+{
+    if(fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    records = 0;
+}
+
+size_t DatasetJournal::getEndOffset() const
+{
+    // markers are appended w/ another descriptor: offset is taken from the file
+    struct stat journalStat;
+    if(!isOpen() || fstat(fd, &journalStat) != 0) {
+        return NO_OFFSET;
+    }
+    return static_cast<size_t>(journalStat.st_size);
+}
+
+
+bool DatasetJournal::append(Operation operation, size_t index, size_t otherIndex)
+{
+    string record{static_cast<char>(operation)};
+    record += " " + to_string(index);
+    if(operation == Operation::SWITCH) {
+        record += " " + to_string(otherIndex);
+    }
+    record += "\n";
+    return append(record);
+}
+
+bool DatasetJournal::append(Operation operation, size_t index, const string& csvRow)
+{
+    string record{static_cast<char>(operation)};
+    record += " " + to_string(index) + " " + csvRow;
+    if(record.back() != '\n') {
+        record += "\n";
+    }
+    return append(record);
+}
+
+bool DatasetJournal::append(const string& record)
+{
+    if(!isOpen()) {
+        return false;
+    }
+    if(!writeRecord(fd, record)) {
+        cerr << "Unable to append to journal " << filePath << ": " << strerror(errno) << endl;
+        close();
+        return false;
+    }
+    records++;
+    return true;
+}
+
+} // namespace etl76
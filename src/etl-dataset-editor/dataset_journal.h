@@ -0,0 +1,159 @@
+/*
+ dataset_journal.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_JOURNAL_H
+#define ETL76_DATASET_JOURNAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "exceptions.h"
+
+namespace etl76 {
+
+/**
+ * @brief Append-only journal of dataset edits (.etlj file).
+ *
+ * Edits are appended to the journal instead of rewriting the whole CSV
+ * file, the journal is compacted (CSV is rewritten and journal is emptied)
+ * once in a while. On start the journal is replayed on top of the CSV.
+ *
+ * Journal is a text file - the 1st line identifies the CSV file (size and
+ * modification time) the journal belongs to, each following line is
+ * a record:
+ *
+ *   I <index> <CSV row>    ... insert row at index
+ *   S <index> <CSV row>    ... set row at index
+ *   R <index>              ... remove row at index
+ *   W <index> <index>      ... switch rows
+ *   C <offset> <CSV id>    ... compaction marker
+ *
+ * Journal of a different CSV file (compaction was interrupted after the CSV
+ * was written) is stale and ignored. Incomplete last record (interrupted
+ * append) is ignored and truncated.
+ *
+ * Compaction runs in background while edits are still appended to the journal:
+ * compaction marker says that records before the offset are in the CSV file
+ * w/ given id. The marker is written before the new CSV replaces the old one
+ * so that records appended during compaction are replayed even if the journal
+ * was not rebased (rewritten to the new CSV w/ records after the offset).
+ */
+class DatasetJournal
+{
+public:
+    static constexpr const char* FILE_EXTENSION = ".etlj";
+    static const unsigned VERSION = 1;
+    // journal is compacted to the CSV when it has this many records
+    static const size_t COMPACTION_RECORDS = 1000;
+    // no journal offset (compaction w/o journal)
+    static const size_t NO_OFFSET = SIZE_MAX;
+
+    enum class Operation : char {
+        INSERT = 'I',
+        SET = 'S',
+        REMOVE = 'R',
+        SWITCH = 'W',
+        COMPACTION = 'C'
+    };
+
+    struct Record
+    {
+        Operation operation;
+        size_t index;
+        // switch: the other index, insert/set: row in rows CSV
+        size_t argument;
+        // journal offset after the record
+        size_t end;
+    };
+
+private:
+    std::string filePath;
+    int fd;
+    size_t records;
+
+    static bool getCsvFileId(const std::string& csvFilePath, std::string& id);
+
+    bool append(const std::string& record);
+
+public:
+    DatasetJournal();
+    DatasetJournal(const DatasetJournal&) = delete;
+    DatasetJournal(const DatasetJournal&&) = delete;
+    DatasetJournal &operator=(const DatasetJournal&) = delete;
+    DatasetJournal &operator=(const DatasetJournal&&) = delete;
+    ~DatasetJournal();
+
+    static std::string journalPath(const std::string& csvFilePath);
+
+    /**
+     * @brief Read records of the CSV file's journal.
+     *
+     * Rows of insert and set records are appended to rowsCsv (one CSV row
+     * per record). Returns size of the valid part of the journal, zero
+     * if journal is missing or stale.
+     */
+    static size_t read(
+            const std::string& csvFilePath,
+            std::vector<Record>& records,
+            std::string& rowsCsv);
+
+    /**
+     * @brief Open journal of the CSV file for appending.
+     *
+     * Valid size is size of the replayed journal - anything after it is
+     * truncated, zero size starts a new journal.
+     */
+    void open(const std::string& csvFilePath, size_t validSize, size_t validRecords);
+    bool isOpen() const { return fd >= 0; }
+    void close();
+
+    /**
+     * @brief Append compaction marker to the journal of CSV file (if exists).
+     *
+     * New CSV file is not yet renamed over the CSV file - marker is synced.
+     */
+    static void markCompaction(
+            const std::string& csvFilePath,
+            const std::string& newCsvFilePath,
+            size_t offset);
+    /**
+     * @brief Rewrite journal to the (compacted) CSV w/ records after the offset.
+     *
+     * Open journal is kept if it cannot be rewritten - compaction marker
+     * makes it valid for the compacted CSV.
+     */
+    void rebase(const std::string& csvFilePath, size_t offset);
+
+    /**
+     * @brief Append record w/ a single write - journal is closed on failure.
+     */
+    bool append(Operation operation, size_t index, size_t otherIndex=0);
+    bool append(Operation operation, size_t index, const std::string& csvRow);
+
+    size_t size() const { return records; }
+    /**
+     * @brief Journal size as in the file (w/ compaction markers appended
+     * by the saver) - NO_OFFSET if the journal is not open.
+     */
+    size_t getEndOffset() const;
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_JOURNAL_H
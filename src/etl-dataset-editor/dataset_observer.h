@@ -0,0 +1,46 @@
+/*
+ dataset_observer.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_OBSERVER_H
+#define ETL76_DATASET_OBSERVER_H
+
+#include <cstddef>
+
+#include "dataset_columns.h"
+
+namespace etl76 {
+
+/**
+ * @brief Observer of dataset edits.
+ *
+ * Inserted row is reported once it is in the columns, removed row before
+ * it is erased - set row is removal of the old row and insertion of the
+ * new one. Row switches are not reported and neither are (re)loads.
+ */
+class DatasetObserver
+{
+public:
+    virtual ~DatasetObserver() {}
+
+    virtual void onRowInserted(const DatasetColumns& columns, size_t row) = 0;
+    virtual void onRowRemoved(const DatasetColumns& columns, size_t row) = 0;
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_OBSERVER_H
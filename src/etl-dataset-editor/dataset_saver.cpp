@@ -0,0 +1,134 @@
+/*
+ dataset_saver.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_saver.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#include "dataset_csv_writer.h"
+#include "dataset_journal.h"
+#include "dataset_snapshot.h"
+#include "statistics.h"
+
+namespace etl76 {
+
+using namespace std;
+
+DatasetSaver::DatasetSaver()
+    : worker()
+{
+}
+
+DatasetSaver::~DatasetSaver()
+{
+    wait();
+}
+
+/*
+ * Rename is durable once the directory is synced.
+ */
+static void syncDirectory(const string& filePath)
+{
+    size_t slash = filePath.find_last_of('/');
+    string directory = slash == string::npos ? string{"."} : filePath.substr(0, max(slash, static_cast<size_t>(1)));
+    int fd = open(directory.c_str(), O_RDONLY|O_DIRECTORY);
+    if(fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+void DatasetSaver::save(
+        const DatasetColumns& columns,
+        const string& filePath,
+        const char* header,
+        size_t journalOffset)
+{
+    string tmpFilePath{filePath+".tmp"};
+    try {
+        DatasetCsvWriter writer{};
+        writer.write(tmpFilePath, header, columns);
+        DatasetJournal::markCompaction(filePath, tmpFilePath, journalOffset);
+    } catch(EtlRuntimeException&) {
+        // the old file is untouched
+        remove(tmpFilePath.c_str());
+        throw;
+    }
+
+    if(rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+        int error = errno;
+        remove(tmpFilePath.c_str());
+        throw EtlRuntimeException(
+            "Unable to replace file "+filePath+": "+strerror(error)
+        );
+    }
+    syncDirectory(filePath);
+
+    try {
+        DatasetSnapshot::write(columns, filePath);
+    } catch(EtlRuntimeException& e) {
+        // stale snapshot must not shadow the new CSV
+        remove(DatasetSnapshot::snapshotPath(filePath).c_str());
+        cerr << e.what() << endl;
+    }
+
+    // statistics are regenerated on every save
+    try {
+        Statistics statistics{};
+        statistics.calculate(columns);
+        statistics.save(filePath);
+    } catch(EtlRuntimeException& e) {
+        cerr << e.what() << endl;
+    }
+}
+
+void DatasetSaver::saveAsync(
+        unique_ptr<DatasetColumns> columns,
+        const string& filePath,
+        const char* header,
+        size_t journalOffset,
+        Callback done)
+{
+    wait();
+
+    // thread owns the copy of the columns
+    shared_ptr<DatasetColumns> job{columns.release()};
+    worker = thread([job, filePath, header, journalOffset, done] {
+        string error{};
+        try {
+            save(*job, filePath, header, journalOffset);
+        } catch(EtlRuntimeException& e) {
+            error = e.what();
+        }
+        done(error);
+    });
+}
+
+void DatasetSaver::wait()
+{
+    if(worker.joinable()) {
+        worker.join();
+    }
+}
+
+} // namespace etl76
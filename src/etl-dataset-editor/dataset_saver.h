@@ -0,0 +1,88 @@
+/*
+ dataset_saver.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_SAVER_H
+#define ETL76_DATASET_SAVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "dataset_columns.h"
+#include "exceptions.h"
+
+namespace etl76 {
+
+/**
+ * @brief Crash-safe dataset saver.
+ *
+ * CSV is written to a temporary file which is synced and atomically
+ * renamed over the CSV file - there is always either the old or the new
+ * complete file. Saver can run in a background thread: it saves its own
+ * immutable copy of the columns so that the editor is not blocked.
+ */
+class DatasetSaver
+{
+public:
+    /**
+     * @brief Called from saver's thread when save finishes - empty error on success.
+     */
+    typedef std::function<void(const std::string& error)> Callback;
+
+private:
+    std::thread worker;
+
+public:
+    DatasetSaver();
+    DatasetSaver(const DatasetSaver&) = delete;
+    DatasetSaver(const DatasetSaver&&) = delete;
+    DatasetSaver &operator=(const DatasetSaver&) = delete;
+    DatasetSaver &operator=(const DatasetSaver&&) = delete;
+    ~DatasetSaver();
+
+    /**
+     * @brief Save columns to CSV file (its snapshot and statistics) in the calling thread.
+     *
+     * Journal offset is the size of the CSV's journal when columns were
+     * copied - see DatasetJournal::markCompaction().
+     */
+    static void save(
+            const DatasetColumns& columns,
+            const std::string& filePath,
+            const char* header,
+            size_t journalOffset);
+
+    /**
+     * @brief Save columns in background thread - previous save must be finished.
+     */
+    void saveAsync(
+            std::unique_ptr<DatasetColumns> columns,
+            const std::string& filePath,
+            const char* header,
+            size_t journalOffset,
+            Callback done);
+    /**
+     * @brief Wait for background save to finish.
+     */
+    void wait();
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_SAVER_H
@@ -0,0 +1,436 @@
+/*
+ dataset_snapshot.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset_snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <sys/stat.h>
+#include <vector>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[4] = {'E', 'T', 'L', 'B'};
+static const uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+static const size_t SNAPSHOT_ALIGNMENT = 8;
+
+/*
+ * Dates can be delta encoded only if every row is a valid calendar date
+ * and deltas fit int32 - otherwise they would not survive the round trip.
+ */
+static bool encodeDates(const DatasetColumns& columns, vector<int32_t>& deltas)
+{
+    const vector<unsigned>& years = columns.getColumn(DatasetColumns::YEAR);
+    const vector<unsigned>& months = columns.getColumn(DatasetColumns::MONTH);
+    const vector<unsigned>& days = columns.getColumn(DatasetColumns::DAY);
+
+    deltas.reserve(columns.size());
+    int64_t previous = 0;
+    for(size_t row=0; row<columns.size(); row++) {
+        if(months[row] < 1 || months[row] > 12 || days[row] < 1 || days[row] > 31) {
+            return false;
+        }
+        int64_t dayNumber = Calendar::daysFromCivil(years[row], months[row], days[row]);
+        int64_t year;
+        unsigned month, day;
+        Calendar::civilFromDays(dayNumber, year, month, day);
+        if(year != years[row] || month != months[row] || day != days[row]) {
+            // 31st of February and friends
+            return false;
+        }
+        int64_t delta = dayNumber - previous;
+        if(delta < INT32_MIN || delta > INT32_MAX) {
+            return false;
+        }
+        deltas.push_back(static_cast<int32_t>(delta));
+        previous = dayNumber;
+    }
+    return true;
+}
+
+/*
+ * Writer
+ */
+
+class SnapshotWriter
+{
+private:
+    const string& filePath;
+    ofstream out;
+    size_t offset;
+
+public:
+    explicit SnapshotWriter(const string& filePath)
+        : filePath(filePath),
+          out(filePath, ios::out|ios::binary|ios::trunc),
+          offset(0)
+    {
+        if(!out) {
+            throw EtlRuntimeException("Unable to create snapshot file "+filePath);
+        }
+    }
+
+    void write(const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+        offset += size;
+    }
+    template<class T> void write(const vector<T>& items) {
+        write(items.data(), items.size()*sizeof(T));
+    }
+    void align() {
+        static const char padding[SNAPSHOT_ALIGNMENT] = {};
+        write(padding, (SNAPSHOT_ALIGNMENT - offset%SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT);
+    }
+
+    /*
+     * Strings are written as offsets and a blob of UTF-8 bytes, dictionary
+     * values are NUL terminated so that they can be interned as C strings.
+     */
+    void writeStrings(const vector<QString>& values) {
+        vector<uint64_t> offsets{};
+        offsets.reserve(values.size()+1);
+        string bytes{};
+        offsets.push_back(0);
+        for(const QString& value:values) {
+            QByteArray utf8 = value.toUtf8();
+            bytes.append(utf8.constData(), static_cast<size_t>(utf8.size()));
+            bytes.push_back(0);
+            offsets.push_back(bytes.size());
+        }
+        write(offsets);
+        write(bytes.data(), bytes.size());
+        align();
+    }
+    void writeStrings(const Utf8Column& column) {
+        vector<uint64_t> offsets{};
+        offsets.reserve(column.size()+1);
+        string bytes{};
+        offsets.push_back(0);
+        for(size_t row=0; row<column.size(); row++) {
+            string_view utf8 = column.getUtf8(row);
+            bytes.append(utf8.data(), utf8.size());
+            offsets.push_back(bytes.size());
+        }
+        write(offsets);
+        write(bytes.data(), bytes.size());
+        align();
+    }
+
+    void close() {
+        out.close();
+        if(!out) {
+            throw EtlRuntimeException("Unable to write snapshot file "+filePath);
+        }
+    }
+};
+
+/*
+ * Reader
+ */
+
+class SnapshotReader
+{
+private:
+    const string& filePath;
+    const char* begin;
+    const char* cursor;
+    const char* end;
+
+public:
+    SnapshotReader(const string& filePath, const char* begin, const char* end)
+        : filePath(filePath),
+          begin(begin),
+          cursor(begin),
+          end(end)
+    {}
+
+    [[noreturn]] void damaged(const string& reason) const {
+        throw EtlRuntimeException(
+            "Snapshot file "+filePath+" is damaged: "+reason
+        );
+    }
+
+    /*
+     * Mapping is page aligned and sections are aligned to 8 bytes so that
+     * fixed width items are used directly from the mapping.
+     */
+    template<class T> const T* take(size_t count) {
+        if(count > static_cast<size_t>(end-cursor)/sizeof(T)) {
+            damaged("unexpected end of file");
+        }
+        const T* items = reinterpret_cast<const T*>(cursor);
+        cursor += count*sizeof(T);
+        return items;
+    }
+    void align() {
+        size_t padding = (SNAPSHOT_ALIGNMENT - (cursor-begin)%SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+        take<char>(padding);
+    }
+
+    /*
+     * Returns offsets (count+1) and bytes of strings, offsets are validated.
+     */
+    const uint64_t* takeStrings(size_t count, const char*& bytes) {
+        const uint64_t* offsets = take<uint64_t>(count+1);
+        if(offsets[0] != 0) {
+            damaged("invalid string offset");
+        }
+        for(size_t i=0; i<count; i++) {
+            if(offsets[i+1] < offsets[i]) {
+                damaged("invalid string offset");
+            }
+        }
+        bytes = take<char>(offsets[count]);
+        align();
+        return offsets;
+    }
+
+    bool atEnd() const { return cursor == end; }
+    size_t remaining() const { return end-cursor; }
+};
+
+/*
+ * Snapshot
+ */
+
+string DatasetSnapshot::siblingPath(const string& csvFilePath, const string& extension)
+{
+    static const string csvExtension{".csv"};
+    if(csvFilePath.size() > csvExtension.size()
+           && csvFilePath.compare(
+               csvFilePath.size()-csvExtension.size(), csvExtension.size(), csvExtension) == 0)
+    {
+        return csvFilePath.substr(0, csvFilePath.size()-csvExtension.size()) + extension;
+    }
+    return csvFilePath + extension;
+}
+
+bool DatasetSnapshot::isFresh(const string& csvFilePath)
+{
+    struct stat csvStat;
+    struct stat snapshotStat;
+    if(stat(csvFilePath.c_str(), &csvStat) != 0
+           || stat(snapshotPath(csvFilePath).c_str(), &snapshotStat) != 0)
+    {
+        return false;
+    }
+    // snapshot is written right after the CSV: it may share the timestamp
+    if(snapshotStat.st_mtim.tv_sec != csvStat.st_mtim.tv_sec) {
+        return snapshotStat.st_mtim.tv_sec > csvStat.st_mtim.tv_sec;
+    }
+    return snapshotStat.st_mtim.tv_nsec >= csvStat.st_mtim.tv_nsec;
+}
+
+void DatasetSnapshot::write(const DatasetColumns& columns, const string& csvFilePath)
+{
+    struct stat csvStat;
+    if(stat(csvFilePath.c_str(), &csvStat) != 0) {
+        throw EtlRuntimeException("Unable to stat CSV file "+csvFilePath);
+    }
+
+    vector<int32_t> deltaDates{};
+    bool isDeltaDates = encodeDates(columns, deltaDates);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.byteOrderMark = SNAPSHOT_BYTE_ORDER_MARK;
+    header.uintColumnCount = DatasetColumns::UINT_COLUMN_COUNT;
+    header.floatColumnCount = DatasetColumns::FLOAT_COLUMN_COUNT;
+    header.stringColumnCount = DatasetColumns::STRING_COLUMN_COUNT;
+    header.categoricalColumnCount = DatasetColumns::CATEGORICAL_COLUMN_COUNT;
+    header.deltaDates = isDeltaDates;
+    header.csvFileSize = static_cast<uint64_t>(csvStat.st_size);
+    header.rows = columns.size();
+
+    // snapshot is written aside and renamed: a reader never sees half of it
+    string filePath{snapshotPath(csvFilePath)};
+    string tmpFilePath{filePath+".tmp"};
+    {
+        SnapshotWriter out{tmpFilePath};
+        out.write(&header, sizeof(header));
+        out.align();
+
+        if(isDeltaDates) {
+            out.write(deltaDates);
+            out.align();
+        }
+        for(int c=0; c<DatasetColumns::UINT_COLUMN_COUNT; c++) {
+            if(isDeltaDates
+                   && (c == DatasetColumns::YEAR || c == DatasetColumns::MONTH || c == DatasetColumns::DAY))
+            {
+                continue;
+            }
+            out.write(columns.uintColumns[c]);
+            out.align();
+        }
+        for(const vector<float>& column:columns.floatColumns) {
+            out.write(column);
+            out.align();
+        }
+        for(int c=0; c<DatasetColumns::CATEGORICAL_COLUMN_COUNT; c++) {
+            const vector<QString>& values = columns.features[c].getValues();
+            uint64_t valueCount = values.size();
+            out.write(&valueCount, sizeof(valueCount));
+            out.writeStrings(values);
+            out.write(columns.categoricalColumns[c]);
+            out.align();
+        }
+        for(const Utf8Column& column:columns.stringColumns) {
+            out.writeStrings(column);
+        }
+
+        out.close();
+    }
+
+    if(rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+        remove(tmpFilePath.c_str());
+        throw EtlRuntimeException("Unable to rename snapshot file "+tmpFilePath);
+    }
+}
+
+void DatasetSnapshot::read(const string& csvFilePath, DatasetColumns& columns)
+{
+    struct stat csvStat;
+    if(stat(csvFilePath.c_str(), &csvStat) != 0) {
+        throw EtlRuntimeException("Unable to stat CSV file "+csvFilePath);
+    }
+
+    string filePath{snapshotPath(csvFilePath)};
+    MappedFile snapshotFile{filePath};
+    SnapshotReader in{filePath, snapshotFile.begin(), snapshotFile.end()};
+
+    const Header& header = *in.take<Header>(1);
+    in.align();
+    if(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        in.damaged("not a snapshot file");
+    }
+    if(header.version != VERSION || header.byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK) {
+        throw EtlRuntimeException(
+            "Snapshot file "+filePath+" has unsupported version or byte order"
+        );
+    }
+    if(header.uintColumnCount != DatasetColumns::UINT_COLUMN_COUNT
+           || header.floatColumnCount != DatasetColumns::FLOAT_COLUMN_COUNT
+           || header.stringColumnCount != DatasetColumns::STRING_COLUMN_COUNT
+           || header.categoricalColumnCount != DatasetColumns::CATEGORICAL_COLUMN_COUNT)
+    {
+        in.damaged("unexpected columns");
+    }
+    if(header.csvFileSize != static_cast<uint64_t>(csvStat.st_size)) {
+        throw EtlRuntimeException(
+            "Snapshot file "+filePath+" was created from different CSV file"
+        );
+    }
+
+    // row has at least its fixed width items and string offsets - damaged
+    // row count must not reserve memory beyond the file
+    const size_t rowBytes = (header.deltaDates ? sizeof(int32_t) : 3*sizeof(uint32_t))
+            + (DatasetColumns::UINT_COLUMN_COUNT-3)*sizeof(uint32_t)
+            + DatasetColumns::FLOAT_COLUMN_COUNT*sizeof(float)
+            + DatasetColumns::CATEGORICAL_COLUMN_COUNT*sizeof(uint32_t)
+            + DatasetColumns::STRING_COLUMN_COUNT*sizeof(uint64_t);
+    if(header.rows > in.remaining()/rowBytes) {
+        in.damaged("invalid row count");
+    }
+    const size_t rows = header.rows;
+    columns.clear();
+    columns.reserve(rows);
+
+    if(header.deltaDates) {
+        const int32_t* deltas = in.take<int32_t>(rows);
+        in.align();
+        vector<unsigned>& years = columns.uintColumns[DatasetColumns::YEAR];
+        vector<unsigned>& months = columns.uintColumns[DatasetColumns::MONTH];
+        vector<unsigned>& days = columns.uintColumns[DatasetColumns::DAY];
+        int64_t dayNumber = 0;
+        for(size_t row=0; row<rows; row++) {
+            dayNumber += deltas[row];
+            int64_t year;
+            unsigned month, day;
+            Calendar::civilFromDays(dayNumber, year, month, day);
+            years.push_back(static_cast<unsigned>(year));
+            months.push_back(month);
+            days.push_back(day);
+        }
+    }
+    for(int c=0; c<DatasetColumns::UINT_COLUMN_COUNT; c++) {
+        if(header.deltaDates
+               && (c == DatasetColumns::YEAR || c == DatasetColumns::MONTH || c == DatasetColumns::DAY))
+        {
+            continue;
+        }
+        const uint32_t* values = in.take<uint32_t>(rows);
+        columns.uintColumns[c].assign(values, values+rows);
+        in.align();
+    }
+    for(vector<float>& column:columns.floatColumns) {
+        const float* values = in.take<float>(rows);
+        column.assign(values, values+rows);
+        in.align();
+    }
+    for(int c=0; c<DatasetColumns::CATEGORICAL_COLUMN_COUNT; c++) {
+        CategoricalFeature& feature = columns.features[c];
+        const uint64_t valueCount = *in.take<uint64_t>(1);
+        // dictionary may have values which are no longer used by rows
+        if(valueCount == 0 || valueCount > snapshotFile.getSize()) {
+            in.damaged("invalid dictionary size");
+        }
+        const char* bytes;
+        const uint64_t* offsets = in.takeStrings(valueCount, bytes);
+        for(size_t code=0; code<valueCount; code++) {
+            if(offsets[code+1] == offsets[code] || bytes[offsets[code+1]-1] != 0) {
+                in.damaged("invalid dictionary value");
+            }
+            // codes are preserved: values are distinct and empty value is the 1st
+            if(feature.intern(bytes+offsets[code]) != code) {
+                in.damaged("invalid dictionary");
+            }
+        }
+        const uint32_t* codes = in.take<uint32_t>(rows);
+        for(size_t row=0; row<rows; row++) {
+            if(codes[row] >= valueCount) {
+                in.damaged("invalid dictionary code");
+            }
+        }
+        columns.categoricalColumns[c].assign(codes, codes+rows);
+        in.align();
+    }
+    for(Utf8Column& column:columns.stringColumns) {
+        const char* bytes;
+        const uint64_t* offsets = in.takeStrings(rows, bytes);
+        column.reserve(rows);
+        for(size_t row=0; row<rows; row++) {
+            column.append(bytes+offsets[row], offsets[row+1]-offsets[row]);
+        }
+    }
+
+    if(!in.atEnd()) {
+        in.damaged("unexpected data after the last column");
+    }
+    columns.rows = rows;
+}
+
+} // namespace etl76
@@ -0,0 +1,105 @@
+/*
+ dataset_snapshot.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATASET_SNAPSHOT_H
+#define ETL76_DATASET_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+#include "dataset_columns.h"
+#include "exceptions.h"
+#include "mapped_file.h"
+
+namespace etl76 {
+
+/**
+ * @brief Binary snapshot of dataset columns (.etlb file).
+ *
+ * Snapshot is a cache of the CSV file (which is the source of truth) that
+ * is loaded w/o text parsing. Snapshot is a header followed by sections
+ * aligned to 8 bytes:
+ *
+ *   - dates: day numbers delta encoded as int32 (1st row is absolute),
+ *     section is missing if dates are not valid calendar dates in which
+ *     case year/month/day are stored as ordinary uint columns
+ *   - uint columns: uint32 x rows each
+ *   - float columns: float32 x rows each
+ *   - categorical columns: dictionary (uint64 offsets x (values+1) and
+ *     NUL terminated UTF-8 values) followed by uint32 codes x rows
+ *   - string columns: uint64 offsets x (rows+1) and UTF-8 bytes
+ *
+ * Fixed width sections are mapped and copied to columns by blocks. Numbers
+ * are in host byte order - snapshot from a host w/ different byte order
+ * is rejected (and CSV is parsed).
+ */
+class DatasetSnapshot
+{
+public:
+    static const uint32_t VERSION = 1;
+    static constexpr const char* FILE_EXTENSION = ".etlb";
+
+    /**
+     * @brief Snapshot header.
+     */
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t uintColumnCount;
+        uint32_t floatColumnCount;
+        uint32_t stringColumnCount;
+        uint32_t categoricalColumnCount;
+        uint32_t deltaDates;
+        // size of the CSV file the snapshot was created from
+        uint64_t csvFileSize;
+        uint64_t rows;
+    };
+
+public:
+    DatasetSnapshot() = delete;
+
+    /**
+     * @brief Path of CSV file's companion: .csv extension is replaced w/ given one.
+     */
+    static std::string siblingPath(const std::string& csvFilePath, const std::string& extension);
+    static std::string snapshotPath(const std::string& csvFilePath) {
+        return siblingPath(csvFilePath, FILE_EXTENSION);
+    }
+    /**
+     * @brief Snapshot exists and it is newer than the CSV file.
+     */
+    static bool isFresh(const std::string& csvFilePath);
+
+    /**
+     * @brief Write snapshot of columns for (already written) CSV file.
+     */
+    static void write(const DatasetColumns& columns, const std::string& csvFilePath);
+    /**
+     * @brief Read snapshot of the CSV file to (empty) columns.
+     *
+     * Throws runtime exception if snapshot is damaged or it was created from
+     * different CSV file.
+     */
+    static void read(const std::string& csvFilePath, DatasetColumns& columns);
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATASET_SNAPSHOT_H
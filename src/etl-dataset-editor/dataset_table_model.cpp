@@ -18,108 +18,275 @@
 */
 #include "dataset_table_model.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace etl76 {
 
 using namespace std;
 
+// passed by reference to vector::assign()
+const int DatasetTableModel::NO_VIEW_ROW;
+
 DatasetTableModel::DatasetTableModel(QObject* parent)
-    : QStandardItemModel(parent)
+    : QAbstractTableModel(parent),
+      dataset(nullptr),
+      filter(),
+      order(),
+      viewRows(),
+      sortColumn(NO_SORT_COLUMN),
+      sortOrder(Qt::AscendingOrder)
 {
-    setColumnCount(9);
-    setRowCount(0);
 }
 
 void DatasetTableModel::removeAllRows()
 {
-    QStandardItemModel::clear();
-
-    QStringList tableHeader;
-    tableHeader
-        << tr("Date")       // 2020/05/21 (use modified:1)
-        << tr("Phase")      // 1
-        << tr("Activity")   // running    (use Notebook:8 ~ non-fixed width)
-        << tr("Description")// Enjoyed w/ 3x300m hard included
-        << tr("Distance")   // 1,250m
-        << tr("Time")       // 1h30m12s
-        << tr("Intensity")  // fatlek
-        // TODO Description
-        << tr("Weight")     // 92.5kg
-        << tr("Fat");       // 12g        (grams of fat burn)
-    // IMPROVE set tooltips: items w/ tooltips instead of just strings
-    setHorizontalHeaderLabels(tableHeader);
+    beginResetModel();
+    dataset = nullptr;
+    order.clear();
+    viewRows.clear();
+    endResetModel();
 }
 
 void DatasetTableModel::setRows(Dataset* dataset)
 {
-    removeAllRows();
-    for(DatasetInstance* instance: dataset->getInstances()) {
-        addRow(instance);
+    beginResetModel();
+    this->dataset = dataset;
+    // row ids and dictionaries changed - the filter is evaluated again
+    selectRows();
+    endResetModel();
+}
+
+void DatasetTableModel::setFilter(const QString& expression)
+{
+    filter.compile(expression);
+    beginResetModel();
+    selectRows();
+    endResetModel();
+}
+
+DatasetInstance* DatasetTableModel::getInstance(int row) const
+{
+    if(!dataset || row < 0 || row >= rowCount()) {
+        return nullptr;
     }
+    return dataset->getInstances()[isIdentity() ? row : order[row]];
 }
 
-void DatasetTableModel::addRow(DatasetInstance* instance)
+int DatasetTableModel::getViewRow(int datasetRow) const
 {
-    QList<QStandardItem*> items;
-    QStandardItem* item;
-
-    cout
-    << "DatasetTable.model: adding year="
-    << instance->getYear() << "/"
-    << instance->getMonth() << "/"
-    << instance->getDay()
-    << endl;
-
-    // year/month/day
-    item = new QStandardItem(instance->getYearMonthDay());
-    // instance as row data
-    item->setData(QVariant::fromValue(instance));
-    // sort
-    //item->setData(QVariant::fromValue((unsigned)(
-    //    instance->getYear()*10000+
-    //    instance->getMonth()*100+
-    //    instance->getDay())),
-    //    Qt::UserRole
-    //);
-    items += item;
-
-    // phase
-    item = new QStandardItem(QString::number(instance->getPhase()));
-    item->setData(QVariant::fromValue((unsigned)(instance->getPhase())), Qt::UserRole);
-    items += item;
-
-    // activity
-    item = new QStandardItem(instance->getActivity().toString());
-    items += item;
-
-    // description
-    item = new QStandardItem(instance->getDescription());
-    items += item;
-
-    // distance
-    item = new QStandardItem(instance->getDistanceMetersStr());
-    item->setData(QVariant::fromValue((unsigned)(instance->getDistanceMeters())), Qt::UserRole);
-    items += item;
-
-    // time
-    item = new QStandardItem(instance->getTotalTimeStr());
-    item->setData(QVariant::fromValue((unsigned)(instance->getTotalTimeSeconds())), Qt::UserRole);
-    items += item;
-
-    // intesity
-    item = new QStandardItem(instance->getIntensity().toString());
-    items += item;
-
-    // weight
-    item = new QStandardItem(instance->getWeightStr());
-    item->setData(QVariant::fromValue((unsigned)(instance->getWeight())), Qt::UserRole);
-    items += item;
-
-    // fat
-    item = new QStandardItem(instance->getGramsOfFatBurntStr());
-    item->setData(QVariant::fromValue((unsigned)(instance->getGramsOfFatBurnt())), Qt::UserRole);
-    items += item;
-
-    appendRow(items);
+    if(isIdentity()) {
+        return datasetRow;
+    }
+    if(datasetRow < 0 || static_cast<size_t>(datasetRow) >= viewRows.size()) {
+        return NO_VIEW_ROW;
+    }
+    return viewRows[datasetRow];
+}
+
+int DatasetTableModel::rowCount(const QModelIndex& parent) const
+{
+    if(parent.isValid() || !dataset) {
+        return 0;
+    }
+    return static_cast<int>(isIdentity() ? dataset->getInstances().size() : order.size());
+}
+
+int DatasetTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant DatasetTableModel::data(const QModelIndex& index, int role) const
+{
+    if(role != Qt::DisplayRole || !index.isValid()) {
+        return QVariant();
+    }
+    const DatasetInstance* instance = getInstance(index.row());
+    if(!instance) {
+        return QVariant();
+    }
+
+    // formatted on demand: only visible cells are asked for
+    switch(index.column()) {
+    case DATE:
+        return instance->getYearMonthDay();
+    case PHASE:
+        return QString::number(instance->getPhase());
+    case ACTIVITY:
+        return instance->getActivity().toString();
+    case DESCRIPTION:
+        return instance->getDescription();
+    case DISTANCE:
+        return instance->getDistanceMetersStr();
+    case TIME:
+        return instance->getTotalTimeStr();
+    case INTENSITY:
+        return instance->getIntensity().toString();
+    case WEIGHT:
+        return instance->getWeightStr();
+    case FAT:
+        return instance->getGramsOfFatBurntStr();
+    }
+    return QVariant();
+}
+
+QVariant DatasetTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    // IMPROVE set tooltips
+    switch(section) {
+    case DATE:
+        return tr("Date");          // 2020/05/21
+    case PHASE:
+        return tr("Phase");         // 1
+    case ACTIVITY:
+        return tr("Activity");      // running
+    case DESCRIPTION:
+        return tr("Description");   // Enjoyed w/ 3x300m hard included
+    case DISTANCE:
+        return tr("Distance");      // 1,250m
+    case TIME:
+        return tr("Time");          // 1h30m12s
+    case INTENSITY:
+        return tr("Intensity");     // fatlek
+    case WEIGHT:
+        return tr("Weight");        // 92.5kg
+    case FAT:
+        return tr("Fat");           // 12g (grams of fat burn)
+    }
+    return QVariant();
+}
+
+/*
+ * Categorical values are sorted by rank of their code so that rows are
+ * compared as integers.
+ */
+static vector<unsigned> rankCodes(const CategoricalFeature& feature)
+{
+    vector<unsigned> codes(feature.size());
+    iota(codes.begin(), codes.end(), 0);
+    sort(codes.begin(), codes.end(), [&feature](unsigned a, unsigned b) {
+        return feature.getValue(a) < feature.getValue(b);
+    });
+    vector<unsigned> ranks(codes.size());
+    for(size_t rank=0; rank<codes.size(); rank++) {
+        ranks[codes[rank]] = static_cast<unsigned>(rank);
+    }
+    return ranks;
+}
+
+void DatasetTableModel::indexViewRows()
+{
+    viewRows.assign(dataset->getInstances().size(), NO_VIEW_ROW);
+    for(size_t viewRow=0; viewRow<order.size(); viewRow++) {
+        viewRows[order[viewRow]] = static_cast<int>(viewRow);
+    }
+}
+
+void DatasetTableModel::selectRows()
+{
+    order.clear();
+    viewRows.clear();
+    if(!dataset || isIdentity()) {
+        return;
+    }
+
+    // all rows if there is no filter
+    filter.select(*dataset, order);
+    if(sortColumn == NO_SORT_COLUMN) {
+        indexViewRows();
+        return;
+    }
+
+    const DatasetColumns& c = dataset->getColumns();
+
+    auto sortBy = [this](auto key) {
+        if(sortOrder == Qt::AscendingOrder) {
+            stable_sort(order.begin(), order.end(), [&key](unsigned a, unsigned b) { return key(a) < key(b); });
+        } else {
+            stable_sort(order.begin(), order.end(), [&key](unsigned a, unsigned b) { return key(b) < key(a); });
+        }
+    };
+    auto sortByCategorical = [&](DatasetColumns::CategoricalColumn column) {
+        const vector<unsigned> ranks = rankCodes(c.getFeature(column));
+        const vector<unsigned>& codes = c.getColumn(column);
+        sortBy([&](unsigned row) { return ranks[codes[row]]; });
+    };
+    auto sortByUnsigned = [&](DatasetColumns::UIntColumn column) {
+        const vector<unsigned>& values = c.getColumn(column);
+        sortBy([&](unsigned row) { return values[row]; });
+    };
+
+    switch(sortColumn) {
+    case DATE: {
+        const vector<unsigned>& years = c.getColumn(DatasetColumns::YEAR);
+        const vector<unsigned>& months = c.getColumn(DatasetColumns::MONTH);
+        const vector<unsigned>& days = c.getColumn(DatasetColumns::DAY);
+        sortBy([&](unsigned row) {
+            return (static_cast<unsigned long long>(years[row])*100 + months[row])*100 + days[row];
+        });
+        break;
+    }
+    case PHASE:
+        sortByUnsigned(DatasetColumns::PHASE);
+        break;
+    case ACTIVITY:
+        sortByCategorical(DatasetColumns::ACTIVITY);
+        break;
+    case DESCRIPTION: {
+        // UTF-8 bytes are in code point order: descriptions are not decoded to be sorted
+        const Utf8Column& descriptions = c.getColumn(DatasetColumns::DESCRIPTION);
+        sortBy([&](unsigned row) { return descriptions.getUtf8(row); });
+        break;
+    }
+    case DISTANCE:
+        sortByUnsigned(DatasetColumns::DISTANCE_METERS);
+        break;
+    case TIME:
+        sortByUnsigned(DatasetColumns::TOTAL_TIME_SECONDS);
+        break;
+    case INTENSITY:
+        sortByCategorical(DatasetColumns::INTENSITY);
+        break;
+    case WEIGHT: {
+        const vector<float>& weights = c.getColumn(DatasetColumns::WEIGHT);
+        sortBy([&](unsigned row) { return weights[row]; });
+        break;
+    }
+    case FAT:
+        sortByUnsigned(DatasetColumns::GRAMS_OF_FAT_BURNT);
+        break;
+    }
+    indexViewRows();
+}
+
+void DatasetTableModel::sort(int column, Qt::SortOrder order)
+{
+    emit layoutAboutToBeChanged();
+
+    // selection follows its dataset rows
+    QModelIndexList persistentIndexes = persistentIndexList();
+    vector<int> datasetRows{};
+    for(const QModelIndex& index:persistentIndexes) {
+        DatasetInstance* instance = getInstance(index.row());
+        datasetRows.push_back(instance ? static_cast<int>(instance->getRow()) : index.row());
+    }
+
+    sortColumn = column;
+    sortOrder = order;
+    selectRows();
+
+    for(int i=0; i<persistentIndexes.size(); i++) {
+        changePersistentIndex(
+            persistentIndexes[i],
+            index(getViewRow(datasetRows[i]), persistentIndexes[i].column()));
+    }
+
+    emit layoutChanged();
 }
 
 } // etl76 namespace
@@ -19,28 +19,93 @@
 #ifndef ETL76_OUTLINES_TABLE_MODEL_H
 #define ETL76_OUTLINES_TABLE_MODEL_H
 
-#include <iostream>
+#include <vector>
 
 #include <QtWidgets>
 
 #include "dataset.h"
-
-Q_DECLARE_METATYPE(etl76::Dataset*)
-Q_DECLARE_METATYPE(etl76::DatasetInstance*)
-
+#include "dataset_filter.h"
 
 namespace etl76 {
 
-class DatasetTableModel : public QStandardItemModel
+/**
+ * @brief Dataset table model.
+ *
+ * Virtual model which answers data() directly from the dataset - nothing
+ * is created per row and display strings are formatted only for the cells
+ * which are painted. Filtering is a selection of dataset rows, sorting
+ * is a permutation of the selection.
+ */
+class DatasetTableModel : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
-    DatasetTableModel(QObject* parent);
+    enum Column {
+        DATE,
+        PHASE,
+        ACTIVITY,
+        DESCRIPTION,
+        DISTANCE,
+        TIME,
+        INTENSITY,
+        WEIGHT,
+        FAT,
+
+        COLUMN_COUNT
+    };
+
+    static const int NO_SORT_COLUMN = -1;
+    static const int NO_VIEW_ROW = -1;
+
+private:
+    Dataset* dataset;
+    DatasetFilter filter;
+    // view row to dataset row - empty if neither filtered nor sorted
+    std::vector<unsigned> order;
+    // dataset row to view row (NO_VIEW_ROW if filtered out) - rebuilt w/ order
+    std::vector<int> viewRows;
+    int sortColumn;
+    Qt::SortOrder sortOrder;
+
+    bool isIdentity() const { return filter.isEmpty() && sortColumn == NO_SORT_COLUMN; }
+    void selectRows();
+    void indexViewRows();
+
+public:
+    explicit DatasetTableModel(QObject* parent);
+    DatasetTableModel(const DatasetTableModel&) = delete;
+    DatasetTableModel(const DatasetTableModel&&) = delete;
+    DatasetTableModel &operator=(const DatasetTableModel&) = delete;
+    DatasetTableModel &operator=(const DatasetTableModel&&) = delete;
 
     void removeAllRows();
+    /**
+     * @brief Show (changed) dataset - current sort is kept.
+     */
     void setRows(Dataset* dataset);
-    void addRow(DatasetInstance* instance);
+    /**
+     * @brief Show only dataset rows matching the filter expression (empty shows all).
+     *
+     * @throws EtlUserException if the expression is not valid - shown rows are kept.
+     */
+    void setFilter(const QString& expression);
+    const DatasetFilter& getFilter() const { return filter; }
+
+    /**
+     * @brief Dataset instance shown in view row.
+     */
+    DatasetInstance* getInstance(int row) const;
+    /**
+     * @brief View row which shows dataset row, NO_VIEW_ROW if it is filtered out.
+     */
+    int getViewRow(int datasetRow) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 };
 
 } // namespace etl76
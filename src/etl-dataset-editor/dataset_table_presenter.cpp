@@ -29,15 +29,11 @@ DatasetTablePresenter::DatasetTablePresenter(DatasetTableView* view)
     this->view->setModel(this->model);
 }
 
-void DatasetTablePresenter::refresh(const vector<DatasetInstance*>& instances, int row)
+void DatasetTablePresenter::refresh(Dataset* dataset, int datasetIndex)
 {
-    model->removeAllRows();
-    if(instances.size()) {
-        for(DatasetInstance* instance:instances) {
-            model->addRow(instance);
-        }
-
-        this->view->setCurrentIndex(this->model->index(row, 0));
+    model->setRows(dataset);
+    if(model->rowCount()) {
+        this->view->setCurrentIndex(this->model->index(model->getViewRow(datasetIndex), 0));
         this->view->setFocus();
     }
 }
@@ -51,4 +47,10 @@ int DatasetTablePresenter::getCurrentRow() const
     return NO_ROW;
 }
 
+int DatasetTablePresenter::getCurrentDatasetIndex() const
+{
+    DatasetInstance* instance = model->getInstance(getCurrentRow());
+    return instance ? static_cast<int>(instance->getRow()) : NO_ROW;
+}
+
 } // etl76 namespace
@@ -48,8 +48,15 @@ public:
     DatasetTableModel* getModel() const { return model; }
     DatasetTableView* getView() const { return view; }
 
-    void refresh(const std::vector<DatasetInstance*>& instances, int row=0);
+    /**
+     * @brief Show dataset and select view row of the dataset index.
+     */
+    void refresh(Dataset* dataset, int datasetIndex=0);
     int getCurrentRow() const;
+    /**
+     * @brief Dataset index of the selected row (view may be sorted).
+     */
+    int getCurrentDatasetIndex() const;
 };
 
 } // namespace etl76
@@ -0,0 +1,191 @@
+/*
+ date_index.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "date_index.h"
+
+#include <algorithm>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+DateIndex::DateIndex()
+    : days(),
+      entries()
+{
+}
+
+int32_t DateIndex::toDay(unsigned year, unsigned month, unsigned day)
+{
+    if(!Calendar::isValidDate(year, month, day)) {
+        return NO_DAY;
+    }
+    const int64_t dayNumber = Calendar::daysFromCivil(year, month, day);
+    return dayNumber > INT32_MIN && dayNumber <= INT32_MAX ? static_cast<int32_t>(dayNumber) : NO_DAY;
+}
+
+int32_t DateIndex::toDay(const DatasetColumns& columns, size_t row)
+{
+    return toDay(
+        columns.get(DatasetColumns::YEAR, row),
+        columns.get(DatasetColumns::MONTH, row),
+        columns.get(DatasetColumns::DAY, row));
+}
+
+static bool entryLess(const DateIndex::Entry& a, const DateIndex::Entry& b)
+{
+    return a.day < b.day || (a.day == b.day && a.instance->getRow() < b.instance->getRow());
+}
+
+void DateIndex::clear()
+{
+    days.clear();
+    entries.clear();
+}
+
+void DateIndex::build(const DatasetColumns& columns, const vector<DatasetInstance*>& instances)
+{
+    clear();
+    days.reserve(columns.size());
+    entries.reserve(columns.size());
+    for(size_t row=0; row<columns.size(); row++) {
+        const int32_t day = toDay(columns, row);
+        days.push_back(day);
+        if(day != NO_DAY) {
+            entries.push_back(Entry{day, instances[row]});
+        }
+    }
+
+    // datasets are typically in chronological or reverse chronological order
+    auto byDay = [](const Entry& a, const Entry& b) { return a.day < b.day; };
+    if(!is_sorted(entries.begin(), entries.end(), byDay)) {
+        auto byDayDescending = [](const Entry& a, const Entry& b) { return a.day > b.day; };
+        if(is_sorted(entries.begin(), entries.end(), byDayDescending)) {
+            // ties keep row order
+            for(auto first = entries.begin(); first != entries.end(); ) {
+                auto last = find_if(first, entries.end(), [first](const Entry& e) { return e.day != first->day; });
+                reverse(first, last);
+                first = last;
+            }
+            reverse(entries.begin(), entries.end());
+        } else {
+            // entries are in row order - stable sort keeps it for ties
+            stable_sort(entries.begin(), entries.end(), byDay);
+        }
+    }
+}
+
+void DateIndex::insertEntry(int32_t day, DatasetInstance* instance)
+{
+    if(day != NO_DAY) {
+        Entry entry{day, instance};
+        entries.insert(lower_bound(entries.begin(), entries.end(), entry, entryLess), entry);
+    }
+}
+
+void DateIndex::eraseEntry(int32_t day, const DatasetInstance* instance)
+{
+    if(day == NO_DAY) {
+        return;
+    }
+    // instance may be out of its place (switched rows) - it is found among entries of its day
+    auto first = lower_bound(entries.begin(), entries.end(), day, [](const Entry& e, int32_t d) { return e.day < d; });
+    for(auto e = first; e != entries.end() && e->day == day; ++e) {
+        if(e->instance == instance) {
+            entries.erase(e);
+            return;
+        }
+    }
+}
+
+void DateIndex::insertRow(const DatasetColumns& columns, size_t row, DatasetInstance* instance)
+{
+    const int32_t day = toDay(columns, row);
+    days.insert(days.begin()+row, day);
+    insertEntry(day, instance);
+}
+
+void DateIndex::setRow(const DatasetColumns& columns, size_t row, DatasetInstance* instance)
+{
+    const int32_t day = toDay(columns, row);
+    if(day != days[row]) {
+        eraseEntry(days[row], instance);
+        days[row] = day;
+        insertEntry(day, instance);
+    }
+}
+
+void DateIndex::eraseRow(size_t row, const DatasetInstance* instance)
+{
+    eraseEntry(days[row], instance);
+    days.erase(days.begin()+row);
+}
+
+void DateIndex::swapRows(size_t a, DatasetInstance* instanceA, size_t b, DatasetInstance* instanceB)
+{
+    // instances are already switched: A is the view of row a
+    swap(days[a], days[b]);
+    eraseEntry(days[a], instanceA);
+    eraseEntry(days[b], instanceB);
+    insertEntry(days[a], instanceA);
+    insertEntry(days[b], instanceB);
+}
+
+DateIndex::Range DateIndex::getRange(int32_t firstDay, int32_t lastDay) const
+{
+    auto first = lower_bound(entries.begin(), entries.end(), firstDay, [](const Entry& e, int32_t d) { return e.day < d; });
+    auto last = upper_bound(first, entries.end(), lastDay, [](int32_t d, const Entry& e) { return d < e.day; });
+    if(last < first) {
+        last = first;
+    }
+    return Range{entries.data()+(first-entries.begin()), entries.data()+(last-entries.begin())};
+}
+
+DateIndex::Range DateIndex::getIsoWeek(int64_t isoYear, unsigned week) const
+{
+    // week 1 is the week w/ 4th of January
+    const int64_t january4 = Calendar::daysFromCivil(isoYear, 1, 4);
+    const int64_t monday = january4 - Calendar::weekday(january4) + 7*(static_cast<int64_t>(week)-1);
+    return getRange(static_cast<int32_t>(monday), static_cast<int32_t>(monday+6));
+}
+
+DateIndex::Range DateIndex::getMonth(unsigned year, unsigned month) const
+{
+    const int32_t first = toDay(year, month, 1);
+    if(first == NO_DAY) {
+        return Range{nullptr, nullptr};
+    }
+    return getRange(first, first + static_cast<int32_t>(Calendar::daysInMonth(year, month)) - 1);
+}
+
+DateIndex::Range DateIndex::getSameDayLastYear(int32_t day) const
+{
+    int64_t year;
+    unsigned month, dayOfMonth;
+    Calendar::civilFromDays(day, year, month, dayOfMonth);
+    year--;
+    if(month == 2 && dayOfMonth == 29) {
+        dayOfMonth = 28;
+    }
+    const int64_t lastYearDay = Calendar::daysFromCivil(year, month, dayOfMonth);
+    return getDay(static_cast<int32_t>(lastYearDay));
+}
+
+} // namespace etl76
@@ -0,0 +1,129 @@
+/*
+ date_index.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_DATE_INDEX_H
+#define ETL76_DATE_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "dataset_columns.h"
+#include "dataset_instance.h"
+
+namespace etl76 {
+
+/**
+ * @brief Date index of dataset rows.
+ *
+ * Every row has a packed date key - day number (see Calendar) - and rows
+ * w/ valid date are kept sorted by the key and row. Order of rows in the
+ * dataset is set by the user, the index answers date range queries in
+ * O(log n + k): rows between two dates, rows of an ISO week, rows of the
+ * same day last year, ...
+ *
+ * Index refers to (stable) instances - row of an instance is its current
+ * position in the dataset. Dataset updates the index on every edit.
+ */
+class DateIndex
+{
+public:
+    static const int32_t NO_DAY = INT32_MIN;
+
+    struct Entry {
+        int32_t day;
+        DatasetInstance* instance;
+    };
+
+    /**
+     * @brief Entries of a query sorted by day and row.
+     */
+    class Range
+    {
+    private:
+        const Entry* first;
+        const Entry* last;
+
+    public:
+        Range(const Entry* first, const Entry* last) : first(first), last(last) {}
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last-first); }
+        bool empty() const { return first == last; }
+    };
+
+private:
+    // day key by row
+    std::vector<int32_t> days;
+    // entries of rows w/ valid date sorted by day and row
+    std::vector<Entry> entries;
+
+    void insertEntry(int32_t day, DatasetInstance* instance);
+    void eraseEntry(int32_t day, const DatasetInstance* instance);
+
+public:
+    DateIndex();
+    DateIndex(const DateIndex&) = delete;
+    DateIndex(const DateIndex&&) = delete;
+    DateIndex &operator=(const DateIndex&) = delete;
+    DateIndex &operator=(const DateIndex&&) = delete;
+
+    /**
+     * @brief Day key of the date - NO_DAY if the date is not valid.
+     */
+    static int32_t toDay(unsigned year, unsigned month, unsigned day);
+    static int32_t toDay(const DatasetColumns& columns, size_t row);
+
+    void clear();
+    /**
+     * @brief Index all rows: I-th instance is the view of I-th row.
+     */
+    void build(const DatasetColumns& columns, const std::vector<DatasetInstance*>& instances);
+
+    /*
+     * Rows are renumbered by dataset before insertion and after erase.
+     */
+
+    void insertRow(const DatasetColumns& columns, size_t row, DatasetInstance* instance);
+    void setRow(const DatasetColumns& columns, size_t row, DatasetInstance* instance);
+    void eraseRow(size_t row, const DatasetInstance* instance);
+    void swapRows(size_t a, DatasetInstance* instanceA, size_t b, DatasetInstance* instanceB);
+
+    int32_t getRowDay(size_t row) const { return days[row]; }
+    size_t size() const { return entries.size(); }
+    /**
+     * @brief All rows w/ valid date.
+     */
+    Range getAll() const { return Range{entries.data(), entries.data()+entries.size()}; }
+
+    /**
+     * @brief Rows from the first to the last day (inclusive).
+     */
+    Range getRange(int32_t firstDay, int32_t lastDay) const;
+    Range getDay(int32_t day) const { return getRange(day, day); }
+    Range getIsoWeek(int64_t isoYear, unsigned week) const;
+    Range getMonth(unsigned year, unsigned month) const;
+    /**
+     * @brief Rows of the same day a year before - 29th of February is 28th.
+     */
+    Range getSameDayLastYear(int32_t day) const;
+};
+
+} // namespace etl76
+
+#endif // ETL76_DATE_INDEX_H
@@ -19,34 +19,76 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++11
-QMAKE_CXXFLAGS += -std=c++0x -pthread
+CONFIG += c++17
+QMAKE_CXXFLAGS += -std=c++17 -pthread
 LIBS += -pthread
 
 DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    analytics_cache.cpp \
+    categorical_feature.cpp \
+    column_kernels.cpp \
     dataset.cpp \
+    dataset_columns.cpp \
+    dataset_csv_reader.cpp \
+    dataset_csv_writer.cpp \
+    dataset_filter.cpp \
     dataset_instance.cpp \
+    dataset_instance_pool.cpp \
+    dataset_journal.cpp \
+    dataset_saver.cpp \
+    dataset_snapshot.cpp \
     dataset_table_model.cpp \
     dataset_table_presenter.cpp \
     dataset_table_view.cpp \
+    date_index.cpp \
     etl_dataset_editor.cpp \
+    gear_ledger.cpp \
+    gear_view.cpp \
     main_window.cpp \
+    mapped_file.cpp \
+    personal_records.cpp \
+    personal_records_view.cpp \
     statistics.cpp \
+    statistics_view.cpp \
+    training_load.cpp \
+    utf8_column.cpp \
     dataset_instance_dialog.cpp
 
 HEADERS += \
+    analytics_cache.h \
+    calendar.h \
+    categorical_feature.h \
+    column_kernels.h \
     csv.h \
     dataset.h \
+    dataset_columns.h \
+    dataset_csv_reader.h \
+    dataset_csv_writer.h \
+    dataset_filter.h \
     dataset_instance.h \
+    dataset_instance_pool.h \
+    dataset_journal.h \
+    dataset_observer.h \
+    dataset_saver.h \
+    dataset_snapshot.h \
     dataset_table_model.h \
     dataset_table_presenter.h \
     dataset_table_view.h \
+    date_index.h \
     exceptions.h \
+    gear_ledger.h \
+    gear_view.h \
     main_window.h \
+    mapped_file.h \
+    personal_records.h \
+    personal_records_view.h \
     statistics.h \
+    statistics_view.h \
+    training_load.h \
+    utf8_column.h \
     dataset_instance_dialog.h
 
 TRANSLATIONS += \
@@ -0,0 +1,185 @@
+/*
+ gear_ledger.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gear_ledger.h"
+
+#include <algorithm>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+GearLedger::GearLedger()
+    : gears(),
+      serviceActivities()
+{
+}
+
+vector<string> GearLedger::parseComponents(const QString& description)
+{
+    vector<string> components{};
+    for(const QString& part:description.split(',')) {
+        const string component = part.trimmed().toLower().toStdString();
+        if(!component.empty() && find(components.begin(), components.end(), component) == components.end()) {
+            components.push_back(component);
+        }
+    }
+    return components;
+}
+
+void GearLedger::classifyActivities(const DatasetColumns& columns)
+{
+    // new values are classified as they are interned
+    const CategoricalFeature& activities = columns.getFeature(DatasetColumns::ACTIVITY);
+    for(unsigned code=serviceActivities.size(); code<activities.size(); code++) {
+        serviceActivities.push_back(activities.getValue(code).toLower() == SERVICE_ACTIVITY);
+    }
+}
+
+void GearLedger::sumUsage(const Gear& gear, Component& component)
+{
+    component.sinceService = Usage{0, 0, 0};
+    const int64_t lastServiceDay = component.getLastServiceDay();
+    for(auto u = gear.usageByDay.upper_bound(lastServiceDay); u != gear.usageByDay.end(); ++u) {
+        component.sinceService.add(u->second, 1);
+    }
+}
+
+void GearLedger::updateRow(const DatasetColumns& c, size_t row, bool insert, bool sum)
+{
+    const unsigned gearCode = c.getColumn(DatasetColumns::GEAR)[row];
+    if(gearCode == CategoricalFeature::EMPTY_CODE) {
+        return;
+    }
+    if(gearCode >= gears.size()) {
+        gears.resize(gearCode+1);
+    }
+    Gear& gear = gears[gearCode];
+    classifyActivities(c);
+
+    const unsigned year = c.get(DatasetColumns::YEAR, row);
+    const unsigned month = c.get(DatasetColumns::MONTH, row);
+    const unsigned dayOfMonth = c.get(DatasetColumns::DAY, row);
+    const int64_t day = Calendar::isValidDate(year, month, dayOfMonth)
+        ? Calendar::daysFromCivil(year, month, dayOfMonth)
+        : NO_DAY;
+    const int sign = insert ? 1 : -1;
+
+    if(serviceActivities[c.getColumn(DatasetColumns::ACTIVITY)[row]]) {
+        // service w/o date can't be placed in the history of the gear
+        if(day == NO_DAY) {
+            return;
+        }
+        for(const string& name:parseComponents(c.get(DatasetColumns::DESCRIPTION, row))) {
+            if(insert) {
+                Component& component = gear.components[name];
+                component.services[day]++;
+                if(sum && day == component.getLastServiceDay()) {
+                    sumUsage(gear, component);
+                }
+                continue;
+            }
+            auto found = gear.components.find(name);
+            if(found == gear.components.end()) {
+                continue;
+            }
+            Component& component = found->second;
+            const int64_t lastServiceDay = component.getLastServiceDay();
+            auto service = component.services.find(day);
+            if(service != component.services.end() && !--service->second) {
+                component.services.erase(service);
+            }
+            if(component.services.empty()) {
+                // component is no longer tracked
+                gear.components.erase(found);
+            } else if(component.getLastServiceDay() != lastServiceDay) {
+                sumUsage(gear, component);
+            }
+        }
+        return;
+    }
+
+    // universal distance/time includes warm up and cool down if known
+    const unsigned totalMeters = c.get(DatasetColumns::TOTAL_DISTANCE_METERS, row);
+    const unsigned totalSeconds = c.get(DatasetColumns::TOTAL_TIME_SECONDS, row);
+    const Usage usage{
+        totalMeters ? totalMeters : c.get(DatasetColumns::DISTANCE_METERS, row),
+        totalSeconds ? totalSeconds : c.get(DatasetColumns::TIME_SECONDS, row),
+        1
+    };
+    gear.total.add(usage, sign);
+    if(day == NO_DAY) {
+        return;
+    }
+    Usage& dayUsage = gear.usageByDay[day];
+    dayUsage.add(usage, sign);
+    if(!dayUsage.activities) {
+        gear.usageByDay.erase(day);
+    }
+    for(auto& nameAndComponent:gear.components) {
+        Component& component = nameAndComponent.second;
+        if(day > component.getLastServiceDay()) {
+            component.sinceService.add(usage, sign);
+        }
+    }
+}
+
+void GearLedger::calculate(const DatasetColumns& c)
+{
+    gears.clear();
+    serviceActivities.clear();
+    classifyActivities(c);
+
+    // usage first, then services w/o summing, then every component once
+    const vector<unsigned>& activities = c.getColumn(DatasetColumns::ACTIVITY);
+    for(size_t row=0; row<c.size(); row++) {
+        if(!serviceActivities[activities[row]]) {
+            updateRow(c, row, true, false);
+        }
+    }
+    for(size_t row=0; row<c.size(); row++) {
+        if(serviceActivities[activities[row]]) {
+            updateRow(c, row, true, false);
+        }
+    }
+    for(Gear& gear:gears) {
+        for(auto& nameAndComponent:gear.components) {
+            sumUsage(gear, nameAndComponent.second);
+        }
+    }
+}
+
+void GearLedger::onRowInserted(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, true, true);
+}
+
+void GearLedger::onRowRemoved(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, false, true);
+}
+
+const GearLedger::Gear* GearLedger::getGear(const DatasetColumns& columns, const QString& name) const
+{
+    const unsigned code = columns.getFeature(DatasetColumns::GEAR).find(name);
+    return code == CategoricalFeature::NO_CODE ? nullptr : getGear(code);
+}
+
+} // namespace etl76
@@ -0,0 +1,128 @@
+/*
+ gear_ledger.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_GEAR_LEDGER_H
+#define ETL76_GEAR_LEDGER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "dataset_columns.h"
+#include "dataset_observer.h"
+
+namespace etl76 {
+
+/**
+ * @brief Gear ledger.
+ *
+ * Distance and time per gear (bike, shoes, ...) and per serviced component
+ * of a gear. Component is tracked once it is serviced - see DatasetInstance:
+ * activity 'servis', gear 'kato', description 'chain' resets chain km on
+ * the bike 'kato' (description may list more components separated by comma).
+ * Since-service usage of a component includes instances of the gear after
+ * the day of its last service.
+ *
+ * Gears are kept by gear dictionary code, their totals and since-service
+ * usage are maintained as dataset observer - query is O(1) per gear.
+ * Instance adds/removes its usage to/from the gear and its components,
+ * service (rare) sums usage of the gear by day after the last service.
+ */
+class GearLedger : public DatasetObserver
+{
+    // analytics are saved to/loaded from cache as they are
+    friend class AnalyticsCache;
+
+public:
+    static constexpr const char* SERVICE_ACTIVITY = "servis";
+    static const int64_t NO_DAY = INT64_MIN;
+
+    struct Usage {
+        uint64_t meters;
+        uint64_t seconds;
+        unsigned activities;
+
+        void add(const Usage& u, int sign) {
+            meters += sign*static_cast<int64_t>(u.meters);
+            seconds += sign*static_cast<int64_t>(u.seconds);
+            activities += sign*static_cast<int>(u.activities);
+        }
+    };
+
+    struct Component {
+        // service count by day
+        std::map<int64_t, unsigned> services;
+        Usage sinceService;
+
+        int64_t getLastServiceDay() const { return services.empty() ? NO_DAY : services.rbegin()->first; }
+    };
+
+    struct Gear {
+        Usage total;
+        // usage of instances w/ valid date
+        std::map<int64_t, Usage> usageByDay;
+        // lowercase UTF-8 component name to component
+        std::map<std::string, Component> components;
+    };
+
+private:
+    // gear by gear dictionary code - empty gear (code 0) is not tracked
+    std::vector<Gear> gears;
+    // whether activity of dictionary code is service
+    std::vector<unsigned char> serviceActivities;
+
+    void classifyActivities(const DatasetColumns& columns);
+    void updateRow(const DatasetColumns& columns, size_t row, bool insert, bool sumUsage);
+    static void sumUsage(const Gear& gear, Component& component);
+
+public:
+    GearLedger();
+    GearLedger(const GearLedger&) = delete;
+    GearLedger(const GearLedger&&) = delete;
+    GearLedger &operator=(const GearLedger&) = delete;
+    GearLedger &operator=(const GearLedger&&) = delete;
+
+    /**
+     * @brief Calculate ledger of all rows - previous ledger is dropped.
+     */
+    void calculate(const DatasetColumns& columns);
+
+    void onRowInserted(const DatasetColumns& columns, size_t row) override;
+    void onRowRemoved(const DatasetColumns& columns, size_t row) override;
+
+    /**
+     * @brief Gear of the gear dictionary code, nullptr if it was not used.
+     */
+    const Gear* getGear(unsigned code) const {
+        return code < gears.size() && gears[code].total.activities+gears[code].components.size() ? &gears[code] : nullptr;
+    }
+    const Gear* getGear(const DatasetColumns& columns, const QString& name) const;
+    size_t getGearCodes() const { return gears.size(); }
+
+    /**
+     * @brief Components of service description: trimmed, lowercase and w/o duplicates.
+     */
+    static std::vector<std::string> parseComponents(const QString& description);
+};
+
+} // namespace etl76
+
+#endif // ETL76_GEAR_LEDGER_H
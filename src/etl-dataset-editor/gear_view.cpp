@@ -0,0 +1,97 @@
+/*
+ gear_view.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gear_view.h"
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+GearView::GearView(QWidget* parent)
+  : QTableWidget(parent)
+{
+    verticalHeader()->setVisible(false);
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    setHorizontalHeaderLabels(QStringList{}
+        << tr("Gear")
+        << tr("Component")
+        << tr("km")
+        << tr("Time")
+        << tr("Instances")
+        << tr("Last service")
+    );
+}
+
+void GearView::refresh(const GearLedger& ledger, const DatasetColumns& columns)
+{
+    const CategoricalFeature& gearNames = columns.getFeature(DatasetColumns::GEAR);
+    auto km = [](double meters) { return QString::number(meters/1000.0, 'f', 1); };
+
+    int row = 0;
+    auto setRow = [this, &row, &km](const QString& gear, const QString& component, const GearLedger::Usage& usage, const QString& lastService) {
+        const QString values[] = {
+            gear,
+            component,
+            km(usage.meters),
+            QString::number(usage.seconds/3600) + "h",
+            QString::number(usage.activities),
+            lastService
+        };
+        if(row >= rowCount()) {
+            setRowCount(row+1);
+        }
+        int column = 0;
+        for(const QString& value:values) {
+            QTableWidgetItem* cell = item(row, column);
+            if(!cell) {
+                setItem(row, column, cell = new QTableWidgetItem{});
+            }
+            cell->setText(value);
+            column++;
+        }
+        row++;
+    };
+
+    for(unsigned code=0; code<ledger.getGearCodes() && code<gearNames.size(); code++) {
+        const GearLedger::Gear* gear = ledger.getGear(code);
+        if(!gear) {
+            continue;
+        }
+        setRow(gearNames.getValue(code), QString{}, gear->total, QString{});
+        for(const auto& nameAndComponent:gear->components) {
+            int64_t year;
+            unsigned month, day;
+            Calendar::civilFromDays(nameAndComponent.second.getLastServiceDay(), year, month, day);
+            setRow(
+                QString{},
+                QString::fromStdString(nameAndComponent.first),
+                nameAndComponent.second.sinceService,
+                QString("%1/%2/%3").arg(year).arg(month, 2, 10, QChar('0')).arg(day, 2, 10, QChar('0')));
+        }
+    }
+    setRowCount(row);
+}
+
+} // etl76 namespace
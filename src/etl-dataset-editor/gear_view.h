@@ -0,0 +1,53 @@
+/*
+ gear_view.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_GEAR_VIEW_H
+#define ETL76_GEAR_VIEW_H
+
+#include <QtWidgets>
+
+#include "dataset_columns.h"
+#include "gear_ledger.h"
+
+namespace etl76 {
+
+/**
+ * @brief Gear panel.
+ *
+ * Row per gear w/ its total usage followed by rows of its serviced
+ * components w/ usage since the last service. Refreshed from (incrementally
+ * maintained) ledger after every edit.
+ */
+class GearView : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GearView(QWidget* parent);
+    GearView(const GearView&) = delete;
+    GearView(const GearView&&) = delete;
+    GearView &operator=(const GearView&) = delete;
+    GearView &operator=(const GearView&&) = delete;
+    virtual ~GearView() override {}
+
+    void refresh(const GearLedger& ledger, const DatasetColumns& columns);
+};
+
+} // namespace etl76
+
+#endif // ETL76_GEAR_VIEW_H
@@ -51,6 +51,8 @@ MainWindow::MainWindow(QWidget* parent)
     QMenu* datasetMenu = menuBar()->addMenu("&Dataset");
     QAction* newInstanceAction = datasetMenu->addAction("&New instance");
     newInstanceAction->setShortcut(QKeySequence(Qt::CTRL+Qt::SHIFT+Qt::Key_N));
+    QAction* filterAction = datasetMenu->addAction("&Filter");
+    filterAction->setShortcut(QKeySequence(Qt::CTRL+Qt::Key_F));
 
     // window
     datasetTableView = new DatasetTableView{this};
@@ -58,6 +60,28 @@ MainWindow::MainWindow(QWidget* parent)
     datasetTablePresenter->getModel()->setRows(&dataset);
 
     setCentralWidget(datasetTableView);
+    filterEdit = new QLineEdit{this};
+    filterEdit->setPlaceholderText(tr("Filter e.g. activity=ride and year>=2015 and distance>50km and gear~29er"));
+    filterEdit->setClearButtonEnabled(true);
+    QToolBar* filterToolBar = addToolBar(tr("Filter"));
+    filterToolBar->addWidget(filterEdit);
+    QDockWidget* statisticsDock = new QDockWidget{tr("Statistics"), this};
+    statisticsView = new StatisticsView{statisticsDock};
+    statisticsDock->setWidget(statisticsView);
+    addDockWidget(Qt::BottomDockWidgetArea, statisticsDock);
+    QDockWidget* gearDock = new QDockWidget{tr("Gear"), this};
+    gearView = new GearView{gearDock};
+    gearDock->setWidget(gearView);
+    addDockWidget(Qt::BottomDockWidgetArea, gearDock);
+    tabifyDockWidget(statisticsDock, gearDock);
+    QDockWidget* personalRecordsDock = new QDockWidget{tr("Records"), this};
+    personalRecordsView = new PersonalRecordsView{personalRecordsDock};
+    personalRecordsDock->setWidget(personalRecordsView);
+    addDockWidget(Qt::BottomDockWidgetArea, personalRecordsDock);
+    tabifyDockWidget(gearDock, personalRecordsDock);
+    statisticsDock->raise();
+    trainingLoadLabel = new QLabel{this};
+    statusBar()->addPermanentWidget(trainingLoadLabel);
     statusBar()->clearMessage();
     setWindowState(Qt::WindowMaximized);
 
@@ -89,6 +113,14 @@ MainWindow::MainWindow(QWidget* parent)
         datasetTableView, SIGNAL(signalMoveSelectedInstanceDown()),
         this, SLOT(slotMoveSelectedInstanceDown())
     );
+    QObject::connect(
+        filterEdit, SIGNAL(textChanged(const QString&)),
+        this, SLOT(slotFilterChanged(const QString&))
+    );
+    QObject::connect(
+        filterAction, SIGNAL(triggered()),
+        filterEdit, SLOT(setFocus())
+    );
     QObject::connect(
         quitAction, SIGNAL(triggered()),
         this, SLOT(close())
@@ -103,26 +135,163 @@ MainWindow::~MainWindow()
 
 void MainWindow::onStart()
 {
+    auto showLoadError = [this](const QString& error) {
+        // dataset which was not loaded stays empty and read only - the file is not overwritten by edits
+        QMessageBox::critical(
+            this,
+            tr("CSV Dataset Load Error"),
+            dataset.isReadOnly() ? tr("%1\n\nDataset is opened read only - edits will not be saved.").arg(error) : error,
+            QMessageBox::Ok
+        );
+    };
+
     if(Dataset::file_exists(datasetPath)) {
         try {
-            dataset.from_csv(datasetPath);
-        } catch(io::error::missing_column_in_header e) {
-            QMessageBox::critical(
-                this,
-                tr("CSV Dataset Load Error"),
-                e.what(),
-                QMessageBox::Ok
-            );
-        } catch(io::error::too_few_columns e) {
-            QMessageBox::critical(
-                this,
-                tr("CSV Dataset Load Error"),
-                e.what(),
-                QMessageBox::Ok
-            );
+            // binary snapshot is loaded w/o parsing unless the CSV is newer
+            if(!dataset.from_snapshot(datasetPath)) {
+                dataset.from_csv(datasetPath);
+            }
+            // edits since the last compaction
+            dataset.open_journal(datasetPath);
+        } catch(io::error::base& e) {
+            showLoadError(QString::fromUtf8(e.what()));
+        } catch(EtlRuntimeException& e) {
+            showLoadError(QString::fromUtf8(e.what()));
         }
     }
     datasetTablePresenter->getModel()->setRows(&dataset);
+    // analytics are calculated (or loaded from cache) once and then updated by edits
+    const DatasetColumns& columns = dataset.getColumns();
+    const uint64_t contentHash = AnalyticsCache::contentHash(columns);
+    const size_t rows = dataset.getInstances().size();
+    if(!AnalyticsCache::read(
+           datasetPath, contentHash, rows,
+           statistics, trainingLoad, gearLedger, personalRecords))
+    {
+        statistics.calculate(columns);
+        trainingLoad.calculate(columns);
+        gearLedger.calculate(columns);
+        personalRecords.calculate(columns);
+        // dataset which was not loaded must not replace the cache of the file
+        if(!dataset.isReadOnly()) {
+            try {
+                AnalyticsCache::write(
+                    datasetPath, contentHash, rows,
+                    statistics, trainingLoad, gearLedger, personalRecords);
+            } catch(EtlRuntimeException& e) {
+                // cache is an optimization only
+                cerr << e.what() << endl;
+            }
+        }
+    }
+    dataset.addObserver(&statistics);
+    statisticsView->refresh(statistics, columns);
+    dataset.addObserver(&trainingLoad);
+    refreshTrainingLoad();
+    dataset.addObserver(&gearLedger);
+    gearView->refresh(gearLedger, columns);
+    dataset.addObserver(&personalRecords);
+    personalRecordsView->refresh(personalRecords, columns);
+    statusBar()->showMessage(
+        tr("%1 instances loaded (%2 kB)")
+            .arg(dataset.getInstances().size())
+            .arg(dataset.getByteSize()/1024)
+    );
+}
+
+void MainWindow::closeEvent(QCloseEvent* event)
+{
+    // journal is compacted to the CSV so that the next start replays nothing,
+    // running background save is waited for
+    if(dataset.getJournalSize() || dataset.is_compacting()) {
+        statusBar()->showMessage(tr("Saving dataset..."));
+        try {
+            dataset.compact(datasetPath);
+        } catch(EtlRuntimeException& e) {
+            // edits are kept in the journal
+            cerr << e.what() << endl;
+        }
+    }
+    event->accept();
+}
+
+void MainWindow::commitDataset()
+{
+    statisticsView->refresh(statistics, dataset.getColumns());
+    refreshTrainingLoad();
+    gearView->refresh(gearLedger, dataset.getColumns());
+    personalRecordsView->refresh(personalRecords, dataset.getColumns());
+
+    bool compacting = dataset.commit(datasetPath, [this](const string& error) {
+        // saver thread: result is handled in the UI thread
+        QMetaObject::invokeMethod(
+            this,
+            [this, error] { handleDatasetSaved(error); },
+            Qt::QueuedConnection
+        );
+    });
+
+    if(dataset.isReadOnly()) {
+        statusBar()->showMessage(tr("Dataset was not loaded - edits are not saved"));
+    } else if(compacting || dataset.is_compacting()) {
+        statusBar()->showMessage(tr("Saving dataset..."));
+    } else {
+        statusBar()->showMessage(tr("Saved (%1 edits in journal)").arg(dataset.getJournalSize()));
+    }
+}
+
+void MainWindow::refreshTrainingLoad()
+{
+    // edited days are recomputed here
+    const vector<TrainingLoad::Day>& days = trainingLoad.getDays();
+    if(days.empty()) {
+        trainingLoadLabel->clear();
+        return;
+    }
+    const TrainingLoad::Day& day = days.back();
+    trainingLoadLabel->setText(
+        tr("Fitness %1  Fatigue %2  Form %3  ACWR %4  Monotony %5")
+            .arg(day.fitness, 0, 'f', 1)
+            .arg(day.fatigue, 0, 'f', 1)
+            .arg(day.form, 0, 'f', 1)
+            .arg(day.acwr, 0, 'f', 2)
+            .arg(day.monotony, 0, 'f', 2)
+    );
+}
+
+void MainWindow::handleDatasetSaved(const string& error)
+{
+    dataset.finish_compaction(datasetPath, error.empty());
+    if(error.empty()) {
+        statusBar()->showMessage(tr("Dataset saved"));
+    } else {
+        statusBar()->showMessage(tr("Dataset save failed"));
+        QMessageBox::critical(
+            this,
+            tr("Dataset Save Error"),
+            QString::fromStdString(error),
+            QMessageBox::Ok
+        );
+    }
+}
+
+void MainWindow::slotFilterChanged(const QString& expression)
+{
+    // filter is evaluated on every keystroke - incomplete expression keeps shown rows
+    try {
+        datasetTablePresenter->getModel()->setFilter(expression);
+        if(expression.trimmed().isEmpty()) {
+            statusBar()->clearMessage();
+        } else {
+            statusBar()->showMessage(
+                tr("%1 of %2 instances match the filter")
+                    .arg(datasetTablePresenter->getModel()->rowCount())
+                    .arg(dataset.getInstances().size())
+            );
+        }
+    } catch(EtlUserException& e) {
+        statusBar()->showMessage(e.what());
+    }
 }
 
 void MainWindow::slotNewInstanceDialog() {
@@ -137,10 +306,10 @@ DatasetInstance* MainWindow::getDatasetTableInstanceForSelectedRow()
     cout << "Edit selected instance: " << row << endl;
 
     if(row != DatasetTablePresenter::NO_ROW) {
-        QStandardItem* item = datasetTablePresenter->getModel()->item(row);
-        if(item) {
-            DatasetInstance* instance=item->data(Qt::UserRole + 1).value<DatasetInstance*>();
-            instance->setDatasetIndex(row);
+        DatasetInstance* instance = datasetTablePresenter->getModel()->getInstance(row);
+        if(instance) {
+            // view row differs from dataset index if the view is sorted
+            instance->setDatasetIndex(static_cast<int>(instance->getRow()));
             return instance;
         } else {
             QMessageBox::warning(
@@ -185,8 +354,8 @@ void MainWindow::slotRemoveSelectedInstance()
         );
         if(decision == QMessageBox::Yes) {
             int index = dataset.removeInstance(instance->getDatasetIndex());
-            dataset.to_csv(datasetPath);
-            datasetTablePresenter->refresh(dataset.getInstances(), index);
+            commitDataset();
+            datasetTablePresenter->refresh(&dataset, index);
         }
     }
 }
@@ -196,8 +365,8 @@ void MainWindow::slotMoveSelectedInstanceUp()
     DatasetInstance* instance = getDatasetTableInstanceForSelectedRow();
     if(instance) {
         int index = dataset.upInstance(instance->getDatasetIndex());
-        dataset.to_csv(datasetPath);
-        datasetTablePresenter->refresh(dataset.getInstances(), index);
+        commitDataset();
+        datasetTablePresenter->refresh(&dataset, index);
     }
 }
 
@@ -206,8 +375,8 @@ void MainWindow::slotMoveSelectedInstanceDown()
     DatasetInstance* instance = getDatasetTableInstanceForSelectedRow();
     if(instance) {
         int index = dataset.downInstance(instance->getDatasetIndex());
-        dataset.to_csv(datasetPath);
-        datasetTablePresenter->refresh(dataset.getInstances(), index);
+        commitDataset();
+        datasetTablePresenter->refresh(&dataset, index);
     }
 }
 
@@ -217,18 +386,18 @@ void MainWindow::slotHandleEditInstance()
         DatasetInstance* instance = editInstanceDialog->toDatasetInstance();
         cout << "Create (or edit) instance: " << editInstanceDialog->isCreateMode() << endl;
         if(editInstanceDialog->isCreateMode()) {
-            int row = datasetTablePresenter->getCurrentRow();
-            if(row == DatasetTablePresenter::NO_ROW) {
+            int index = datasetTablePresenter->getCurrentDatasetIndex();
+            if(index == DatasetTablePresenter::NO_ROW) {
                 instance->setDatasetIndex(0);
             } else {
-                instance->setDatasetIndex(row);
+                instance->setDatasetIndex(index);
             }
             dataset.insertInstance(instance);
         } else {
             dataset.setInstance(editInstanceDialog->getDatasetIndex(), instance);
         }
         datasetTablePresenter->getModel()->setRows(&dataset);
-        dataset.to_csv(datasetPath);
+        commitDataset();
     } catch(EtlUserException e) {
         QMessageBox::warning(
             this,
@@ -20,14 +20,23 @@
 
 #include <iostream>
 
+#include <QCloseEvent>
 #include <QMainWindow>
 
+#include "analytics_cache.h"
 #include "dataset.h"
 #include "dataset_table_view.h"
 #include "dataset_table_model.h"
 #include "dataset_table_presenter.h"
 #include "dataset_instance_dialog.h"
 #include "dataset_instance_check_dialog.h"
+#include "gear_ledger.h"
+#include "gear_view.h"
+#include "personal_records.h"
+#include "personal_records_view.h"
+#include "statistics.h"
+#include "statistics_view.h"
+#include "training_load.h"
 
 
 namespace etl76 {
@@ -39,18 +48,35 @@ class MainWindow : public QMainWindow
 private:
     std::string datasetPath;
     Dataset dataset;
+    // kept up to date by the dataset as its observer
+    Statistics statistics;
+    TrainingLoad trainingLoad;
+    GearLedger gearLedger;
+    PersonalRecords personalRecords;
 
     DatasetTableView* datasetTableView;
     DatasetTablePresenter* datasetTablePresenter;
+    QLineEdit* filterEdit;
+    StatisticsView* statisticsView;
+    GearView* gearView;
+    PersonalRecordsView* personalRecordsView;
+    QLabel* trainingLoadLabel;
 
     DatasetInstanceDialog* editInstanceDialog;
 
+    void commitDataset();
+    void refreshTrainingLoad();
+    void handleDatasetSaved(const std::string& error);
+
 public:
     MainWindow(QWidget* parent = nullptr);
     ~MainWindow();
 
     void onStart();
 
+protected:
+    void closeEvent(QCloseEvent* event) override;
+
 private slots:
     DatasetInstance* getDatasetTableInstanceForSelectedRow();
 
@@ -60,6 +86,7 @@ private slots:
     void slotMoveSelectedInstanceDown();
     void slotNewInstanceDialog();
     void slotHandleEditInstance();
+    void slotFilterChanged(const QString& expression);
 
 };
 
@@ -0,0 +1,80 @@
+/*
+ mapped_file.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace etl76 {
+
+using namespace std;
+
+MappedFile::MappedFile(const string& filePath)
+    : filePath(filePath),
+      data(nullptr),
+      size(0)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw EtlRuntimeException(
+            "Unable to open file "+filePath+": "+strerror(errno)
+        );
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0) {
+        int error = errno;
+        close(fd);
+        throw EtlRuntimeException(
+            "Unable to stat file "+filePath+": "+strerror(error)
+        );
+    }
+
+    // empty file cannot be mapped - it is represented as empty range
+    size = static_cast<size_t>(fileStat.st_size);
+    if(size) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw EtlRuntimeException(
+                "Unable to map file "+filePath+": "+strerror(error)
+            );
+        }
+        // file is parsed front to back
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+    }
+
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if(data) {
+        munmap(const_cast<char*>(data), size);
+    }
+}
+
+} // namespace etl76
@@ -0,0 +1,57 @@
+/*
+ mapped_file.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_MAPPED_FILE_H
+#define ETL76_MAPPED_FILE_H
+
+#include <string>
+
+#include "exceptions.h"
+
+namespace etl76 {
+
+/**
+ * @brief Memory mapped file.
+ *
+ * File is mapped read only - parsers work w/ views to the mapping so that
+ * its pages stay clean page cache pages (never copied on write).
+ */
+class MappedFile
+{
+private:
+    std::string filePath;
+    const char* data;
+    size_t size;
+
+public:
+    explicit MappedFile(const std::string& filePath);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(const MappedFile&&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&&) = delete;
+    ~MappedFile();
+
+    const std::string& getFilePath() const { return filePath; }
+    const char* begin() const { return data; }
+    const char* end() const { return data+size; }
+    size_t getSize() const { return size; }
+};
+
+} // namespace etl76
+
+#endif // ETL76_MAPPED_FILE_H
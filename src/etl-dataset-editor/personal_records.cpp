@@ -0,0 +1,199 @@
+/*
+ personal_records.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "personal_records.h"
+
+#include <algorithm>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+// passed by reference to min()
+const unsigned PersonalRecords::TOP;
+
+const vector<unsigned> PersonalRecords::ROWING_DISTANCES = {500, 2000, 5000, 10000, 21097};
+const vector<unsigned> PersonalRecords::RUNNING_DISTANCES = {5000, 10000, 21097, 42195};
+
+PersonalRecords::PersonalRecords()
+    : boards(),
+      activityClasses()
+{
+}
+
+void PersonalRecords::classifyActivities(const DatasetColumns& columns)
+{
+    // new values are classified as they are interned
+    const CategoricalFeature& activities = columns.getFeature(DatasetColumns::ACTIVITY);
+    for(unsigned code=activityClasses.size(); code<activities.size(); code++) {
+        activityClasses.push_back(static_cast<unsigned char>(Statistics::classifyActivity(activities.getUtf8Value(code))));
+    }
+}
+
+/*
+ * Records of a row: op(key, record) is called for every board of the row.
+ */
+template<class Op>
+void PersonalRecords::forEachRecord(const DatasetColumns& c, size_t row, Op op) const
+{
+    const unsigned activity = c.getColumn(DatasetColumns::ACTIVITY)[row];
+    if(activity == CategoricalFeature::EMPTY_CODE) {
+        return;
+    }
+
+    const unsigned year = c.get(DatasetColumns::YEAR, row);
+    const unsigned month = c.get(DatasetColumns::MONTH, row);
+    const unsigned dayOfMonth = c.get(DatasetColumns::DAY, row);
+    const bool dated = Calendar::isValidDate(year, month, dayOfMonth);
+    const unsigned seasons[] = {ALL_TIME, year};
+    const size_t seasonCount = dated && year != ALL_TIME ? 2 : 1;
+
+    // efforts w/o warm up and cool down
+    const unsigned meters = c.get(DatasetColumns::DISTANCE_METERS, row);
+    const unsigned seconds = c.get(DatasetColumns::TIME_SECONDS, row);
+    Record record{dated ? Calendar::daysFromCivil(year, month, dayOfMonth) : NO_DAY, meters, seconds, 0};
+
+    auto report = [&](Category category, unsigned distance, unsigned value) {
+        if(value) {
+            record.value = value;
+            for(size_t s=0; s<seasonCount; s++) {
+                op(Key{category, activity, distance, seasons[s]}, record);
+            }
+        }
+    };
+
+    const ActivityClass activityClass = static_cast<ActivityClass>(activityClasses[activity]);
+    const vector<unsigned>* distances
+        = activityClass == ActivityClass::C2 ? &ROWING_DISTANCES
+        : activityClass == ActivityClass::RUNNING ? &RUNNING_DISTANCES
+        : nullptr;
+    if(distances) {
+        for(unsigned distance:*distances) {
+            if(meters >= distance && meters <= distance*(1+DISTANCE_TOLERANCE)) {
+                report(BEST_TIME, distance, seconds);
+            }
+        }
+    }
+    report(LONGEST_DISTANCE, 0, meters);
+    report(MOST_ELEVATION, 0, c.get(DatasetColumns::ELEVATION_GAIN, row));
+    report(BEST_AVG_WATTS, 0, c.get(DatasetColumns::AVG_WATTS, row));
+}
+
+/*
+ * Board
+ */
+
+static void insertRecord(PersonalRecords::Category category, PersonalRecords::Board& board, const PersonalRecords::Record& record)
+{
+    vector<PersonalRecords::Record>& records = board.records;
+    auto position = upper_bound(records.begin(), records.end(), record,
+        [category](const PersonalRecords::Record& a, const PersonalRecords::Record& b) {
+            return PersonalRecords::isBetter(category, a, b);
+        });
+    // dropped records may be better than a record after the worst one
+    if((records.size() >= PersonalRecords::CAPACITY || board.truncated) && position == records.end()) {
+        board.truncated = true;
+        return;
+    }
+    records.insert(position, record);
+    if(records.size() > PersonalRecords::CAPACITY) {
+        records.pop_back();
+        board.truncated = true;
+    }
+}
+
+void PersonalRecords::refill(const DatasetColumns& c, const Key& key, Board& board, size_t removedRow)
+{
+    board.records.clear();
+    board.truncated = false;
+    const vector<unsigned>& activities = c.getColumn(DatasetColumns::ACTIVITY);
+    for(size_t row=0; row<c.size(); row++) {
+        if(row == removedRow || activities[row] != key.activity) {
+            continue;
+        }
+        forEachRecord(c, row, [&](const Key& k, const Record& record) {
+            if(!(k < key) && !(key < k)) {
+                insertRecord(key.category, board, record);
+            }
+        });
+    }
+}
+
+void PersonalRecords::updateRow(const DatasetColumns& c, size_t row, bool insert)
+{
+    classifyActivities(c);
+    forEachRecord(c, row, [&](const Key& key, const Record& record) {
+        if(insert) {
+            insertRecord(key.category, boards[key], record);
+            return;
+        }
+        auto found = boards.find(key);
+        if(found == boards.end()) {
+            return;
+        }
+        Board& board = found->second;
+        auto r = find(board.records.begin(), board.records.end(), record);
+        if(r == board.records.end()) {
+            // dropped (or never recorded)
+            return;
+        }
+        board.records.erase(r);
+        if(board.truncated && board.records.size() < TOP) {
+            refill(c, key, board, row);
+        }
+        if(board.records.empty()) {
+            boards.erase(found);
+        }
+    });
+}
+
+void PersonalRecords::calculate(const DatasetColumns& c)
+{
+    boards.clear();
+    activityClasses.clear();
+    classifyActivities(c);
+    for(size_t row=0; row<c.size(); row++) {
+        forEachRecord(c, row, [this](const Key& key, const Record& record) {
+            insertRecord(key.category, boards[key], record);
+        });
+    }
+}
+
+void PersonalRecords::onRowInserted(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, true);
+}
+
+void PersonalRecords::onRowRemoved(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, false);
+}
+
+vector<PersonalRecords::Record> PersonalRecords::getTop(const Key& key, unsigned k) const
+{
+    auto found = boards.find(key);
+    if(found == boards.end()) {
+        return vector<Record>{};
+    }
+    const vector<Record>& records = found->second.records;
+    return vector<Record>(records.begin(), records.begin()+min<size_t>(min(k, TOP), records.size()));
+}
+
+} // namespace etl76
@@ -0,0 +1,158 @@
+/*
+ personal_records.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_PERSONAL_RECORDS_H
+#define ETL76_PERSONAL_RECORDS_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "dataset_columns.h"
+#include "dataset_observer.h"
+#include "statistics.h"
+
+namespace etl76 {
+
+/**
+ * @brief Personal records.
+ *
+ * Boards of the best instances per category, activity and season (year
+ * or all time):
+ *
+ * - best time of standard distances (rowing 500m/2k/5k/10k/21k, running
+ *   5k/10k/HM/M) - instance distance must be the standard distance or
+ *   a bit longer (GPS/erg tolerance),
+ * - longest distance (e.g. longest ride),
+ * - most elevation gain,
+ * - best average watts.
+ *
+ * Board keeps the CAPACITY best records sorted - it is the exact top of
+ * all instances as worse instances are dropped. Dataset observer inserts
+ * a record to/removes it from its boards in O(log n) w/o scan, only when
+ * removals deplete a board w/ dropped instances below TOP it is refilled
+ * by a scan of the columns. Records are values (not rows) so that row
+ * renumbering does not affect boards.
+ */
+class PersonalRecords : public DatasetObserver
+{
+    // analytics are saved to/loaded from cache as they are
+    friend class AnalyticsCache;
+
+public:
+    // exact records available for every board
+    static const unsigned TOP = 10;
+    static const unsigned CAPACITY = 3*TOP;
+    static const unsigned ALL_TIME = 0;
+    static const int64_t NO_DAY = INT64_MIN;
+    // instance may be this much longer than the standard distance
+    static constexpr double DISTANCE_TOLERANCE = 0.02;
+
+    static const std::vector<unsigned> ROWING_DISTANCES;
+    static const std::vector<unsigned> RUNNING_DISTANCES;
+
+    enum Category {
+        BEST_TIME,
+        LONGEST_DISTANCE,
+        MOST_ELEVATION,
+        BEST_AVG_WATTS,
+
+        CATEGORY_COUNT
+    };
+
+    struct Key {
+        Category category;
+        // activity dictionary code
+        unsigned activity;
+        // standard distance of the best time, otherwise 0
+        unsigned distance;
+        // year or ALL_TIME
+        unsigned season;
+
+        bool operator<(const Key& k) const {
+            if(category != k.category) return category < k.category;
+            if(activity != k.activity) return activity < k.activity;
+            if(distance != k.distance) return distance < k.distance;
+            return season < k.season;
+        }
+    };
+
+    struct Record {
+        int64_t day;
+        unsigned meters;
+        unsigned seconds;
+        // seconds (best time), meters, elevation or watts
+        unsigned value;
+
+        bool operator==(const Record& r) const {
+            return day == r.day && meters == r.meters && seconds == r.seconds && value == r.value;
+        }
+    };
+
+    struct Board {
+        // best first, ties by day
+        std::vector<Record> records;
+        // worse records were dropped
+        bool truncated;
+    };
+
+private:
+    std::map<Key, Board> boards;
+    // activity class by activity dictionary code
+    std::vector<unsigned char> activityClasses;
+
+    void classifyActivities(const DatasetColumns& columns);
+    template<class Op> void forEachRecord(const DatasetColumns& columns, size_t row, Op op) const;
+    void updateRow(const DatasetColumns& columns, size_t row, bool insert);
+    void refill(const DatasetColumns& columns, const Key& key, Board& board, size_t removedRow);
+
+public:
+    PersonalRecords();
+    PersonalRecords(const PersonalRecords&) = delete;
+    PersonalRecords(const PersonalRecords&&) = delete;
+    PersonalRecords &operator=(const PersonalRecords&) = delete;
+    PersonalRecords &operator=(const PersonalRecords&&) = delete;
+
+    /**
+     * @brief Lower time is better, otherwise higher value.
+     */
+    static bool isBetter(Category category, const Record& a, const Record& b) {
+        if(a.value != b.value) {
+            return category == BEST_TIME ? a.value < b.value : a.value > b.value;
+        }
+        return a.day < b.day;
+    }
+
+    /**
+     * @brief Calculate all boards - previous boards are dropped.
+     */
+    void calculate(const DatasetColumns& columns);
+
+    void onRowInserted(const DatasetColumns& columns, size_t row) override;
+    void onRowRemoved(const DatasetColumns& columns, size_t row) override;
+
+    const std::map<Key, Board>& getBoards() const { return boards; }
+    /**
+     * @brief Up to k (<= TOP) best records of the board, best first.
+     */
+    std::vector<Record> getTop(const Key& key, unsigned k=TOP) const;
+};
+
+} // namespace etl76
+
+#endif // ETL76_PERSONAL_RECORDS_H
@@ -0,0 +1,139 @@
+/*
+ personal_records_view.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "personal_records_view.h"
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+PersonalRecordsView::PersonalRecordsView(QWidget* parent)
+  : QTableWidget(parent)
+{
+    verticalHeader()->setVisible(false);
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    setHorizontalHeaderLabels(QStringList{}
+        << tr("Activity")
+        << tr("Record")
+        << tr("All time")
+        << tr("Date")
+        << tr("Season")
+        << tr("Season best")
+    );
+}
+
+static QString recordName(const PersonalRecords::Key& key)
+{
+    switch(key.category) {
+    case PersonalRecords::BEST_TIME:
+        return key.distance%1000
+            ? QObject::tr("Best %1m").arg(key.distance)
+            : QObject::tr("Best %1km").arg(key.distance/1000);
+    case PersonalRecords::LONGEST_DISTANCE:
+        return QObject::tr("Longest distance");
+    case PersonalRecords::MOST_ELEVATION:
+        return QObject::tr("Most elevation");
+    case PersonalRecords::BEST_AVG_WATTS:
+        return QObject::tr("Best avg watts");
+    default:
+        return QString{};
+    }
+}
+
+static QString recordValue(PersonalRecords::Category category, const PersonalRecords::Record& record)
+{
+    switch(category) {
+    case PersonalRecords::BEST_TIME:
+        return QString("%1:%2:%3")
+            .arg(record.value/3600)
+            .arg(record.value/60%60, 2, 10, QChar('0'))
+            .arg(record.value%60, 2, 10, QChar('0'));
+    case PersonalRecords::LONGEST_DISTANCE:
+        return QString::number(record.value/1000.0, 'f', 1) + "km";
+    case PersonalRecords::MOST_ELEVATION:
+        return QString::number(record.value) + "m";
+    case PersonalRecords::BEST_AVG_WATTS:
+        return QString::number(record.value) + "W";
+    default:
+        return QString{};
+    }
+}
+
+static QString recordDate(const PersonalRecords::Record& record)
+{
+    if(record.day == PersonalRecords::NO_DAY) {
+        return QString{};
+    }
+    int64_t year;
+    unsigned month, day;
+    Calendar::civilFromDays(record.day, year, month, day);
+    return QString("%1/%2/%3").arg(year).arg(month, 2, 10, QChar('0')).arg(day, 2, 10, QChar('0'));
+}
+
+void PersonalRecordsView::refresh(const PersonalRecords& records, const DatasetColumns& columns)
+{
+    const CategoricalFeature& activities = columns.getFeature(DatasetColumns::ACTIVITY);
+    const map<PersonalRecords::Key, PersonalRecords::Board>& boards = records.getBoards();
+
+    int row = 0;
+    for(auto b = boards.begin(); b != boards.end(); ++b) {
+        const PersonalRecords::Key& key = b->first;
+        if(key.season != PersonalRecords::ALL_TIME || b->second.records.empty() || key.activity >= activities.size()) {
+            continue;
+        }
+        // seasons of the board follow the all time one - the latest is the last
+        auto latest = b;
+        for(auto s = next(b); s != boards.end() && s->first.category == key.category
+                && s->first.activity == key.activity && s->first.distance == key.distance; ++s) {
+            latest = s;
+        }
+
+        const PersonalRecords::Record& best = b->second.records.front();
+        const QString values[] = {
+            activities.getValue(key.activity),
+            recordName(key),
+            recordValue(key.category, best),
+            recordDate(best),
+            latest == b ? QString{} : QString::number(latest->first.season),
+            latest == b ? QString{} : recordValue(key.category, latest->second.records.front())
+        };
+        if(row >= rowCount()) {
+            setRowCount(row+1);
+        }
+        int column = 0;
+        for(const QString& value:values) {
+            QTableWidgetItem* cell = item(row, column);
+            if(!cell) {
+                setItem(row, column, cell = new QTableWidgetItem{});
+            }
+            cell->setText(value);
+            column++;
+        }
+        row++;
+    }
+    setRowCount(row);
+}
+
+} // etl76 namespace
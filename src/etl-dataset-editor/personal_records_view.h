@@ -0,0 +1,53 @@
+/*
+ personal_records_view.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_PERSONAL_RECORDS_VIEW_H
+#define ETL76_PERSONAL_RECORDS_VIEW_H
+
+#include <QtWidgets>
+
+#include "dataset_columns.h"
+#include "personal_records.h"
+
+namespace etl76 {
+
+/**
+ * @brief Personal records panel.
+ *
+ * All time best record of every board followed by the best record of the
+ * latest season - refreshed from (incrementally maintained) records after
+ * every edit.
+ */
+class PersonalRecordsView : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PersonalRecordsView(QWidget* parent);
+    PersonalRecordsView(const PersonalRecordsView&) = delete;
+    PersonalRecordsView(const PersonalRecordsView&&) = delete;
+    PersonalRecordsView &operator=(const PersonalRecordsView&) = delete;
+    PersonalRecordsView &operator=(const PersonalRecordsView&&) = delete;
+    virtual ~PersonalRecordsView() override {}
+
+    void refresh(const PersonalRecords& records, const DatasetColumns& columns);
+};
+
+} // namespace etl76
+
+#endif // ETL76_PERSONAL_RECORDS_VIEW_H
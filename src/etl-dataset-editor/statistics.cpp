@@ -18,10 +18,672 @@
 */
 #include "statistics.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "calendar.h"
+#include "column_kernels.h"
+#include "dataset_snapshot.h"
+
 namespace etl76 {
 
+using namespace std;
+
+const char* Statistics::FILE_SUFFIXES[PERIOD_COUNT] = {
+    "-weekly.csv",
+    "-monthly.csv",
+    "-yearly.csv"
+};
+
+/*
+ * Activities
+ */
+
+ActivityClass Statistics::classifyActivity(const string& activity)
+{
+    static const pair<const char*, ActivityClass> ACTIVITIES[] = {
+        {"ride", ActivityClass::CYCLING},
+        {"bike", ActivityClass::CYCLING},
+        {"cycling", ActivityClass::CYCLING},
+        {"virtualride", ActivityClass::CYCLING},
+        {"ebikeride", ActivityClass::CYCLING},
+        {"mtb", ActivityClass::CYCLING},
+        {"rowing", ActivityClass::C2},
+        {"row", ActivityClass::C2},
+        {"c2", ActivityClass::C2},
+        {"concept2", ActivityClass::C2},
+        {"run", ActivityClass::RUNNING},
+        {"running", ActivityClass::RUNNING},
+        {"virtualrun", ActivityClass::RUNNING},
+        {"trailrun", ActivityClass::RUNNING},
+        {"sauna", ActivityClass::SAUNA},
+        {"meditation", ActivityClass::MEDITATION}
+    };
+
+    string name{activity};
+    for(char& c:name) {
+        if(c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    for(const auto& a:ACTIVITIES) {
+        if(name == a.first) {
+            return a.second;
+        }
+    }
+    return ActivityClass::OTHER;
+}
+
+/*
+ * Aggregation
+ */
+
+/*
+ * Aggregates of one period found by key - the last one is cached as rows
+ * of the same week/month/year are typically next to each other.
+ */
+class PeriodAggregates
+{
+private:
+    Statistics::Aggregates& aggregates;
+    int64_t lastKey;
+    Statistics::Aggregate* last;
+
+public:
+    explicit PeriodAggregates(Statistics::Aggregates& aggregates)
+        : aggregates(aggregates),
+          lastKey(INT64_MIN),
+          last(nullptr)
+    {
+    }
+
+    Statistics::Aggregate& get(int64_t year, unsigned period) {
+        const int64_t key = Statistics::key(year, period);
+        if(key != lastKey) {
+            auto found = aggregates.find(key);
+            if(found == aggregates.end()) {
+                Statistics::Aggregate aggregate{};
+                aggregate.year = year;
+                aggregate.period = period;
+                found = aggregates.emplace(key, std::move(aggregate)).first;
+            }
+            lastKey = key;
+            last = &found->second;
+        }
+        return *last;
+    }
+};
+
+struct RowValues {
+    int64_t day;
+    uint64_t meters;
+    uint64_t seconds;
+    ActivityClass activity;
+    uint64_t repetitions;
+    float weight;
+};
+
+static void aggregateWeighing(Statistics::Aggregate& a, const Statistics::Weighing& w)
+{
+    if(a.weighings.empty()) {
+        a.minWeight = a.maxWeight = w.weight;
+        a.firstWeightDay = a.lastWeightDay = w.day;
+        a.firstWeight = a.lastWeight = w.weight;
+    } else {
+        a.minWeight = min(a.minWeight, w.weight);
+        a.maxWeight = max(a.maxWeight, w.weight);
+        // weighings of the same day are ordered by weight - delta does not
+        // depend on the order of rows
+        if(w.day < a.firstWeightDay || (w.day == a.firstWeightDay && w.weight < a.firstWeight)) {
+            a.firstWeightDay = w.day;
+            a.firstWeight = w.weight;
+        }
+        if(w.day > a.lastWeightDay || (w.day == a.lastWeightDay && w.weight > a.lastWeight)) {
+            a.lastWeightDay = w.day;
+            a.lastWeight = w.weight;
+        }
+    }
+    a.weighings.push_back(w);
+}
+
+/*
+ * Row is added (sign 1) or subtracted (sign -1) - sums are exact integers
+ * except weight sum which is not used for extremes.
+ */
+static void aggregateRow(Statistics::Aggregate& a, const RowValues& row, int sign)
+{
+    a.instances += sign;
+    a.universalMeters += sign*row.meters;
+    a.universalSeconds += sign*row.seconds;
+    switch(row.activity) {
+    case ActivityClass::CYCLING:
+        a.cyclingMeters += sign*row.meters;
+        break;
+    case ActivityClass::C2:
+        a.c2Meters += sign*row.meters;
+        break;
+    case ActivityClass::RUNNING:
+        a.runningMeters += sign*row.meters;
+        break;
+    case ActivityClass::SAUNA:
+        // sauna's repetitions are rounds
+        a.saunaRounds += sign*(row.repetitions ? static_cast<unsigned>(row.repetitions) : 1);
+        break;
+    case ActivityClass::MEDITATION:
+        a.meditations += sign;
+        break;
+    case ActivityClass::OTHER:
+        break;
+    }
+    if(row.activity != ActivityClass::SAUNA) {
+        a.repetitions += sign*row.repetitions;
+    }
+
+    if(row.weight > 0) {
+        a.weightSum += sign*row.weight;
+        if(sign > 0) {
+            aggregateWeighing(a, Statistics::Weighing{row.day, row.weight});
+        } else {
+            auto found = find_if(a.weighings.begin(), a.weighings.end(), [&row](const Statistics::Weighing& w) {
+                return w.day == row.day && w.weight == row.weight;
+            });
+            if(found != a.weighings.end()) {
+                // extremes are restored from the remaining weighings of the aggregate
+                vector<Statistics::Weighing> weighings{};
+                weighings.swap(a.weighings);
+                weighings.erase(found);
+                for(const Statistics::Weighing& w:weighings) {
+                    aggregateWeighing(a, w);
+                }
+            }
+            if(a.weighings.empty()) {
+                a.weightSum = 0;
+            }
+        }
+    }
+}
+
+static void readRow(
+        const DatasetColumns& c,
+        size_t row,
+        const vector<unsigned char>& activityClasses,
+        RowValues& values)
+{
+    values.day = Calendar::daysFromCivil(
+        c.get(DatasetColumns::YEAR, row),
+        c.get(DatasetColumns::MONTH, row),
+        c.get(DatasetColumns::DAY, row));
+    // universal distance/time includes warm up and cool down if known
+    const unsigned totalMeters = c.get(DatasetColumns::TOTAL_DISTANCE_METERS, row);
+    const unsigned totalSeconds = c.get(DatasetColumns::TOTAL_TIME_SECONDS, row);
+    values.meters = totalMeters ? totalMeters : c.get(DatasetColumns::DISTANCE_METERS, row);
+    values.seconds = totalSeconds ? totalSeconds : c.get(DatasetColumns::TIME_SECONDS, row);
+    const unsigned activityCode = c.getColumn(DatasetColumns::ACTIVITY)[row];
+    values.activity = activityCode < activityClasses.size()
+        ? static_cast<ActivityClass>(activityClasses[activityCode])
+        : ActivityClass::OTHER;
+    if(values.activity == ActivityClass::SAUNA) {
+        values.repetitions = c.get(DatasetColumns::REPETITIONS, row);
+    } else {
+        values.repetitions = static_cast<uint64_t>(c.get(DatasetColumns::SQUATS, row))
+            + c.get(DatasetColumns::PUSH_UPS, row)
+            + c.get(DatasetColumns::CRUNCHES, row)
+            + c.get(DatasetColumns::TURTLES, row)
+            + c.get(DatasetColumns::CALFS, row)
+            + c.get(DatasetColumns::REPETITIONS, row);
+    }
+    values.weight = c.get(DatasetColumns::WEIGHT, row);
+}
+
 Statistics::Statistics()
+    : aggregates(),
+      skippedRows(0),
+      activityClasses()
 {
 }
 
+void Statistics::classifyActivities(const DatasetColumns& columns)
+{
+    // activity of every row is classified by its dictionary code - new
+    // values are classified as they are interned
+    const CategoricalFeature& activities = columns.getFeature(DatasetColumns::ACTIVITY);
+    for(unsigned code=activityClasses.size(); code<activities.size(); code++) {
+        activityClasses.push_back(static_cast<unsigned char>(classifyActivity(activities.getUtf8Value(code))));
+    }
+}
+
+/*
+ * Partial aggregates of a chunk of rows are merged to aggregates of the
+ * preceding rows: sums are integers and weighings are appended in row
+ * order so that the weight sum is added in the same order as by a single
+ * thread - merged statistics are exactly the same.
+ */
+static void mergeAggregate(Statistics::Aggregate& a, const Statistics::Aggregate& b)
+{
+    a.instances += b.instances;
+    a.universalMeters += b.universalMeters;
+    a.universalSeconds += b.universalSeconds;
+    a.cyclingMeters += b.cyclingMeters;
+    a.c2Meters += b.c2Meters;
+    a.runningMeters += b.runningMeters;
+    a.repetitions += b.repetitions;
+    a.saunaRounds += b.saunaRounds;
+    a.meditations += b.meditations;
+    for(const Statistics::Weighing& w:b.weighings) {
+        a.weightSum += w.weight;
+        aggregateWeighing(a, w);
+    }
+}
+
+static size_t aggregateRows(
+        const DatasetColumns& c,
+        size_t from,
+        size_t to,
+        const vector<unsigned char>& activityClasses,
+        Statistics::Aggregates* aggregates)
+{
+    const vector<unsigned>& years = c.getColumn(DatasetColumns::YEAR);
+    const vector<unsigned>& months = c.getColumn(DatasetColumns::MONTH);
+    const vector<unsigned>& days = c.getColumn(DatasetColumns::DAY);
+
+    PeriodAggregates weekAggregates{aggregates[Statistics::WEEK]};
+    PeriodAggregates monthAggregates{aggregates[Statistics::MONTH]};
+    PeriodAggregates yearAggregates{aggregates[Statistics::YEAR]};
+
+    size_t skippedRows = 0;
+    RowValues values;
+    for(size_t row=from; row<to; row++) {
+        if(!Calendar::isValidDate(years[row], months[row], days[row])) {
+            skippedRows++;
+            continue;
+        }
+        readRow(c, row, activityClasses, values);
+
+        int64_t isoYear;
+        unsigned week;
+        Calendar::isoWeek(values.day, isoYear, week);
+
+        aggregateRow(weekAggregates.get(isoYear, week), values, 1);
+        aggregateRow(monthAggregates.get(years[row], months[row]), values, 1);
+        aggregateRow(yearAggregates.get(years[row], 0), values, 1);
+    }
+    return skippedRows;
+}
+
+void Statistics::calculate(const DatasetColumns& c, size_t threads)
+{
+    for(Aggregates& a:aggregates) {
+        a.clear();
+    }
+    skippedRows = 0;
+    activityClasses.clear();
+    classifyActivities(c);
+
+    size_t chunkCount = threads ? threads : max(1u, thread::hardware_concurrency());
+    chunkCount = max(static_cast<size_t>(1), min(chunkCount, c.size()/PARALLEL_MIN_ROWS));
+    const size_t chunkSize = (c.size()+chunkCount-1)/chunkCount;
+
+    // 1st chunk is aggregated by the calling thread directly to aggregates
+    vector<unique_ptr<Aggregates[]>> partials{};
+    vector<size_t> partialSkippedRows(chunkCount);
+    vector<thread> workers{};
+    // running workers must not see the vectors reallocated
+    partials.reserve(chunkCount-1);
+    workers.reserve(chunkCount-1);
+    for(size_t i=1; i<chunkCount; i++) {
+        partials.push_back(unique_ptr<Aggregates[]>(new Aggregates[PERIOD_COUNT]));
+        Aggregates* partial = partials.back().get();
+        workers.push_back(thread([&, i, partial] {
+            partialSkippedRows[i] = aggregateRows(
+                c, i*chunkSize, min(c.size(), (i+1)*chunkSize), activityClasses, partial);
+        }));
+    }
+    skippedRows = aggregateRows(c, 0, min(c.size(), chunkSize), activityClasses, aggregates);
+    for(thread& worker:workers) {
+        worker.join();
+    }
+
+    // merge in row order
+    for(size_t i=1; i<chunkCount; i++) {
+        skippedRows += partialSkippedRows[i];
+        for(int p=0; p<PERIOD_COUNT; p++) {
+            for(auto& keyAndAggregate:partials[i-1][p]) {
+                auto found = aggregates[p].find(keyAndAggregate.first);
+                if(found == aggregates[p].end()) {
+                    aggregates[p].emplace(keyAndAggregate.first, std::move(keyAndAggregate.second));
+                } else {
+                    mergeAggregate(found->second, keyAndAggregate.second);
+                }
+            }
+        }
+    }
+}
+
+void Statistics::updateRow(const DatasetColumns& c, size_t row, bool insert)
+{
+    const unsigned year = c.get(DatasetColumns::YEAR, row);
+    const unsigned month = c.get(DatasetColumns::MONTH, row);
+    if(!Calendar::isValidDate(year, month, c.get(DatasetColumns::DAY, row))) {
+        skippedRows += insert ? 1 : -1;
+        return;
+    }
+    classifyActivities(c);
+
+    RowValues values;
+    readRow(c, row, activityClasses, values);
+    int64_t isoYear;
+    unsigned week;
+    Calendar::isoWeek(values.day, isoYear, week);
+
+    const pair<int64_t, unsigned> periods[PERIOD_COUNT] = {{isoYear, week}, {year, month}, {year, 0}};
+    for(int p=0; p<PERIOD_COUNT; p++) {
+        Aggregates& periodAggregates = aggregates[p];
+        if(insert) {
+            aggregateRow(PeriodAggregates{periodAggregates}.get(periods[p].first, periods[p].second), values, 1);
+            continue;
+        }
+        auto found = periodAggregates.find(key(periods[p].first, periods[p].second));
+        if(found != periodAggregates.end()) {
+            aggregateRow(found->second, values, -1);
+            // empty week/month/year is not reported
+            if(!found->second.instances) {
+                periodAggregates.erase(found);
+            }
+        }
+    }
+}
+
+void Statistics::onRowInserted(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, true);
+}
+
+void Statistics::onRowRemoved(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, false);
+}
+
+double Statistics::getAvgMeters(const Aggregate& year, Period period) const
+{
+    // year's weeks are ISO weeks of its ISO year
+    const Aggregates& periods = aggregates[period];
+    auto first = periods.lower_bound(key(year.year, 0));
+    auto last = periods.lower_bound(key(year.year+1, 0));
+    if(period == YEAR || first == last) {
+        return static_cast<double>(year.universalMeters);
+    }
+    --last;
+    return static_cast<double>(year.universalMeters) / (last->second.period - first->second.period + 1);
+}
+
+/*
+ * Totals
+ */
+
+typedef ColumnKernels::Mask Mask;
+
+static Mask maskZero(const DatasetColumns& c, DatasetColumns::UIntColumn column)
+{
+    const vector<unsigned>& values = c.getColumn(column);
+    Mask mask(values.size());
+    ColumnKernels::maskEqual(values.data(), values.size(), 0, mask.data());
+    return mask;
+}
+
+/*
+ * Universal distance/time (total if known, otherwise of the main part) - rows
+ * w/o total are selected by the mask of zero totals.
+ */
+static uint64_t sumUniversal(
+        const DatasetColumns& c,
+        DatasetColumns::UIntColumn total,
+        DatasetColumns::UIntColumn part)
+{
+    const Mask noTotal = maskZero(c, total);
+    return ColumnKernels::summarize(c, total).sum + ColumnKernels::summarize(c, part, &noTotal).sum;
+}
+
+static uint64_t sumRepetitions(const DatasetColumns& c)
+{
+    static const DatasetColumns::UIntColumn EXERCISES[] = {
+        DatasetColumns::SQUATS,
+        DatasetColumns::PUSH_UPS,
+        DatasetColumns::CRUNCHES,
+        DatasetColumns::TURTLES,
+        DatasetColumns::CALFS,
+        DatasetColumns::REPETITIONS
+    };
+
+    uint64_t repetitions = 0;
+    for(DatasetColumns::UIntColumn exercise:EXERCISES) {
+        repetitions += ColumnKernels::summarize(c, exercise).sum;
+    }
+    return repetitions;
+}
+
+/*
+ * Sums of activity classes in one pass over rows - class of a row is looked
+ * up by its activity code (a mask per code would cost a pass per code).
+ * Sums of all rows are added by the pass too unless kernels are vectorized:
+ * scalar kernel reads a column per sum.
+ */
+static void sumRows(
+        const DatasetColumns& c,
+        const vector<unsigned char>& activityClasses,
+        bool allRows,
+        Statistics::Totals& totals)
+{
+    // sums are local while rows are read so that they are kept in registers
+    Statistics::Totals t{totals};
+    double weightSum = 0;
+    const vector<unsigned>& activities = c.getColumn(DatasetColumns::ACTIVITY);
+    const vector<unsigned>& totalMeters = c.getColumn(DatasetColumns::TOTAL_DISTANCE_METERS);
+    const vector<unsigned>& meters = c.getColumn(DatasetColumns::DISTANCE_METERS);
+    const vector<unsigned>& totalSeconds = c.getColumn(DatasetColumns::TOTAL_TIME_SECONDS);
+    const vector<unsigned>& seconds = c.getColumn(DatasetColumns::TIME_SECONDS);
+    const vector<unsigned>& repetitions = c.getColumn(DatasetColumns::REPETITIONS);
+    const vector<float>& weights = c.getColumn(DatasetColumns::WEIGHT);
+    const vector<unsigned>& squats = c.getColumn(DatasetColumns::SQUATS);
+    const vector<unsigned>& pushUps = c.getColumn(DatasetColumns::PUSH_UPS);
+    const vector<unsigned>& crunches = c.getColumn(DatasetColumns::CRUNCHES);
+    const vector<unsigned>& turtles = c.getColumn(DatasetColumns::TURTLES);
+    const vector<unsigned>& calfs = c.getColumn(DatasetColumns::CALFS);
+    auto rowRepetitions = [&](size_t row) {
+        return static_cast<uint64_t>(squats[row]) + pushUps[row] + crunches[row]
+            + turtles[row] + calfs[row] + repetitions[row];
+    };
+
+    for(size_t row=0; row<c.size(); row++) {
+        const unsigned code = activities[row];
+        const ActivityClass activity = code < activityClasses.size()
+            ? static_cast<ActivityClass>(activityClasses[code]) : ActivityClass::OTHER;
+        const unsigned universalMeters = totalMeters[row] ? totalMeters[row] : meters[row];
+
+        switch(activity) {
+        case ActivityClass::CYCLING:
+            t.cyclingMeters += universalMeters;
+            break;
+        case ActivityClass::C2:
+            t.c2Meters += universalMeters;
+            break;
+        case ActivityClass::RUNNING:
+            t.runningMeters += universalMeters;
+            break;
+        case ActivityClass::SAUNA:
+            // sauna's repetitions are rounds (1 if not set) - not workout repetitions
+            t.saunaRounds += repetitions[row] ? repetitions[row] : 1;
+            if(!allRows) {
+                // kernels summed repetitions of all rows
+                t.repetitions -= rowRepetitions(row);
+            }
+            break;
+        case ActivityClass::MEDITATION:
+            t.meditations++;
+            break;
+        case ActivityClass::OTHER:
+            break;
+        }
+
+        if(allRows) {
+            t.universalMeters += universalMeters;
+            t.universalSeconds += totalSeconds[row] ? totalSeconds[row] : seconds[row];
+            if(activity != ActivityClass::SAUNA) {
+                t.repetitions += rowRepetitions(row);
+            }
+            if(weights[row] > 0) {
+                t.minWeight = t.weighings ? min(t.minWeight, weights[row]) : weights[row];
+                t.maxWeight = t.weighings ? max(t.maxWeight, weights[row]) : weights[row];
+                weightSum += weights[row];
+                t.weighings++;
+            }
+        }
+    }
+    if(allRows) {
+        t.avgWeight = t.weighings ? weightSum/t.weighings : 0;
+    }
+
+    totals = t;
+}
+
+/*
+ * Totals are sums of yearly aggregates plus rows w/o valid date.
+ */
+Statistics::Totals Statistics::getTotals(const DatasetColumns& c) const
+{
+    Totals t{};
+    t.instances = c.size();
+
+    if(ColumnKernels::getInstructionSet() == ColumnKernels::InstructionSet::SCALAR) {
+        sumRows(c, activityClasses, true, t);
+        return t;
+    }
+
+    t.universalMeters = sumUniversal(c, DatasetColumns::TOTAL_DISTANCE_METERS, DatasetColumns::DISTANCE_METERS);
+    t.universalSeconds = sumUniversal(c, DatasetColumns::TOTAL_TIME_SECONDS, DatasetColumns::TIME_SECONDS);
+    t.repetitions = sumRepetitions(c);
+    sumRows(c, activityClasses, false, t);
+
+    const Mask weighed = ColumnKernels::maskPositive(c, DatasetColumns::WEIGHT);
+    const ColumnKernels::FloatSummary weight = ColumnKernels::summarize(c, DatasetColumns::WEIGHT, &weighed);
+    t.weighings = weight.count;
+    t.avgWeight = weight.getMean();
+    t.minWeight = weight.min;
+    t.maxWeight = weight.max;
+
+    return t;
+}
+
+/*
+ * Save
+ */
+
+string Statistics::statisticsPath(const string& csvFilePath, Period period)
+{
+    return DatasetSnapshot::siblingPath(csvFilePath, FILE_SUFFIXES[period]);
+}
+
+static void appendInteger(string& out, int64_t value)
+{
+    char buffer[32];
+    out.append(buffer, to_chars(buffer, buffer+sizeof(buffer), value).ptr);
+}
+
+static void appendFixed(string& out, double value, int precision)
+{
+    char buffer[64];
+    out.append(buffer, to_chars(buffer, buffer+sizeof(buffer), value, chars_format::fixed, precision).ptr);
+}
+
+static void appendKm(string& out, double meters)
+{
+    appendFixed(out, meters/1000.0, 3);
+}
+
+static void formatAggregates(
+        const Statistics& statistics,
+        Statistics::Period period,
+        string& out)
+{
+    static const char* PERIOD_COLUMNS[Statistics::PERIOD_COUNT] = {"year,week,", "year,month,", "year,"};
+    out.append(PERIOD_COLUMNS[period]);
+    out.append(
+        "instances,universal_km,universal_time_seconds,cycling_km,c2_km,running_km,"
+        "repetitions,avg_weight,min_weight,max_weight,weight_delta,sauna_rounds,meditations"
+    );
+    if(period == Statistics::YEAR) {
+        out.append(",avg_weekly_km,avg_monthly_km");
+    }
+    out.push_back('\n');
+
+    for(const auto& keyAndAggregate:statistics.getAggregates(period)) {
+        const Statistics::Aggregate& a = keyAndAggregate.second;
+        appendInteger(out, a.year);
+        out.push_back(',');
+        if(period != Statistics::YEAR) {
+            appendInteger(out, a.period);
+            out.push_back(',');
+        }
+        appendInteger(out, a.instances);
+        out.push_back(',');
+        appendKm(out, a.universalMeters);
+        out.push_back(',');
+        appendInteger(out, static_cast<int64_t>(a.universalSeconds));
+        out.push_back(',');
+        appendKm(out, a.cyclingMeters);
+        out.push_back(',');
+        appendKm(out, a.c2Meters);
+        out.push_back(',');
+        appendKm(out, a.runningMeters);
+        out.push_back(',');
+        appendInteger(out, static_cast<int64_t>(a.repetitions));
+        out.push_back(',');
+        // weights are empty if there is no weighing in the period
+        if(a.getWeighings()) {
+            appendFixed(out, a.getAvgWeight(), 2);
+            out.push_back(',');
+            appendFixed(out, a.minWeight, 2);
+            out.push_back(',');
+            appendFixed(out, a.maxWeight, 2);
+            out.push_back(',');
+            appendFixed(out, a.getWeightDelta(), 2);
+        } else {
+            out.append(",,,");
+        }
+        out.push_back(',');
+        appendInteger(out, a.saunaRounds);
+        out.push_back(',');
+        appendInteger(out, a.meditations);
+        if(period == Statistics::YEAR) {
+            out.push_back(',');
+            appendKm(out, statistics.getAvgMeters(a, Statistics::WEEK));
+            out.push_back(',');
+            appendKm(out, statistics.getAvgMeters(a, Statistics::MONTH));
+        }
+        out.push_back('\n');
+    }
+}
+
+void Statistics::save(const string& csvFilePath) const
+{
+    string out{};
+    for(int p=0; p<PERIOD_COUNT; p++) {
+        const Period period = static_cast<Period>(p);
+        out.clear();
+        formatAggregates(*this, period, out);
+
+        const string filePath{statisticsPath(csvFilePath, period)};
+        ofstream file{filePath, ios::binary|ios::trunc};
+        file.write(out.data(), static_cast<streamsize>(out.size()));
+        file.close();
+        if(!file) {
+            throw EtlRuntimeException("Unable to write statistics file "+filePath);
+        }
+    }
+}
+
 } // namespace etl76
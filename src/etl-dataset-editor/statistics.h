@@ -19,9 +19,26 @@
 #ifndef ETL76_STATISTICS_H
 #define ETL76_STATISTICS_H
 
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dataset_columns.h"
+#include "dataset_observer.h"
+#include "exceptions.h"
 
 namespace etl76 {
 
+enum class ActivityClass : unsigned char {
+    OTHER,
+    CYCLING,
+    C2,
+    RUNNING,
+    SAUNA,
+    MEDITATION
+};
+
 /**
  * @brief Statistics.
  *
@@ -49,11 +66,169 @@ namespace etl76 {
  * - avg weekly km
  * - avg montly km
  *
+ * All three granularities are aggregated in one pass over the columns
+ * (weeks are ISO 8601 weeks). Rows may be in any order - aggregates are
+ * found by period key, consecutive rows of a (mostly) sorted dataset hit
+ * the same aggregates w/o a lookup. Large datasets are split to chunks
+ * of rows aggregated by threads, partial aggregates are merged in row
+ * order - the result is exactly the same as aggregated by one thread.
+ *
+ * Once calculated, statistics are kept up to date as dataset observer:
+ * inserted/removed row updates only its week, month and year aggregate.
+ * Weighings of an aggregate are kept so that min/max and first/last
+ * weight can be restored when a row is removed.
+ *
+ * Totals of the whole dataset are not maintained - they are summarized
+ * from the columns when asked for: by vectorized column kernels plus a pass
+ * over rows for activity classes, or by the pass only if kernels are scalar.
  */
-class Statistics
+class Statistics : public DatasetObserver
 {
+    // analytics are saved to/loaded from cache as they are
+    friend class AnalyticsCache;
+
+public:
+    enum Period {
+        WEEK,
+        MONTH,
+        YEAR,
+
+        PERIOD_COUNT
+    };
+
+    static const char* FILE_SUFFIXES[PERIOD_COUNT];
+    // smaller chunks are not worth a thread
+    static const size_t PARALLEL_MIN_ROWS = 1<<15;
+
+    struct Weighing {
+        int64_t day;
+        float weight;
+    };
+
+    /**
+     * @brief Statistics of a week, month or year.
+     */
+    struct Aggregate {
+        // ISO year of a week
+        int64_t year;
+        // ISO week, month or 0 for year
+        unsigned period;
+
+        unsigned instances;
+
+        uint64_t universalMeters;
+        uint64_t universalSeconds;
+        uint64_t cyclingMeters;
+        uint64_t c2Meters;
+        uint64_t runningMeters;
+        uint64_t repetitions;
+
+        // weight 0 is not set
+        std::vector<Weighing> weighings;
+        double weightSum;
+        float minWeight;
+        float maxWeight;
+        int64_t firstWeightDay;
+        float firstWeight;
+        int64_t lastWeightDay;
+        float lastWeight;
+
+        unsigned saunaRounds;
+        unsigned meditations;
+
+        size_t getWeighings() const { return weighings.size(); }
+        float getAvgWeight() const { return weighings.size() ? static_cast<float>(weightSum/weighings.size()) : 0; }
+        float getWeightDelta() const { return weighings.size() ? lastWeight-firstWeight : 0; }
+    };
+
+    /**
+     * @brief Totals of all rows (w/ rows w/o valid date).
+     */
+    struct Totals {
+        size_t instances;
+
+        uint64_t universalMeters;
+        uint64_t universalSeconds;
+        uint64_t cyclingMeters;
+        uint64_t c2Meters;
+        uint64_t runningMeters;
+        uint64_t repetitions;
+
+        // weight 0 is not set
+        size_t weighings;
+        double avgWeight;
+        float minWeight;
+        float maxWeight;
+
+        uint64_t saunaRounds;
+        uint64_t meditations;
+    };
+
+    /**
+     * @brief Aggregates of a period by key: year*100 + period.
+     */
+    typedef std::map<int64_t, Aggregate> Aggregates;
+
+    static int64_t key(int64_t year, unsigned period) { return year*100 + period; }
+
+    /**
+     * @brief Class of activity name (case insensitive).
+     */
+    static ActivityClass classifyActivity(const std::string& activity);
+
+private:
+    Aggregates aggregates[PERIOD_COUNT];
+    size_t skippedRows;
+    // activity class by activity dictionary code
+    std::vector<unsigned char> activityClasses;
+
+    void classifyActivities(const DatasetColumns& columns);
+    void updateRow(const DatasetColumns& columns, size_t row, bool insert);
+
 public:
     Statistics();
+    Statistics(const Statistics&) = delete;
+    Statistics(const Statistics&&) = delete;
+    Statistics &operator=(const Statistics&) = delete;
+    Statistics &operator=(const Statistics&&) = delete;
+
+    /**
+     * @brief Calculate statistics of all rows - previous statistics are dropped.
+     *
+     * @param threads   maximum number of threads, 0 for the number of cores.
+     */
+    void calculate(const DatasetColumns& columns, size_t threads=0);
+
+    void onRowInserted(const DatasetColumns& columns, size_t row) override;
+    void onRowRemoved(const DatasetColumns& columns, size_t row) override;
+
+    /**
+     * @brief Aggregates sorted by year and period.
+     */
+    const Aggregates& getAggregates(Period period) const { return aggregates[period]; }
+    /**
+     * @brief Rows w/o valid date are not aggregated.
+     */
+    size_t getSkippedRows() const { return skippedRows; }
+    /**
+     * @brief Average weekly/monthly meters of a year - over the weeks/months
+     * from the first to the last one w/ an instance (the current year is
+     * not complete).
+     */
+    double getAvgMeters(const Aggregate& year, Period period) const;
+    /**
+     * @brief Totals of the columns which statistics were calculated for.
+     */
+    Totals getTotals(const DatasetColumns& columns) const;
+
+    /**
+     * @brief Path of the statistics file which is saved next to the CSV file.
+     */
+    static std::string statisticsPath(const std::string& csvFilePath, Period period);
+    /**
+     * @brief Save weekly, monthly and yearly statistics as CSV files next to the CSV file.
+     */
+    void save(const std::string& csvFilePath) const;
 };
 
 } // namespace etl76
@@ -0,0 +1,123 @@
+/*
+ statistics_view.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "statistics_view.h"
+
+namespace etl76 {
+
+using namespace std;
+
+StatisticsView::StatisticsView(QWidget* parent)
+  : QTableWidget(parent)
+{
+    verticalHeader()->setVisible(false);
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    setHorizontalHeaderLabels(QStringList{}
+        << tr("Year")
+        << tr("Instances")
+        << tr("km")
+        << tr("Time")
+        << tr("Cycling km")
+        << tr("C2 km")
+        << tr("Running km")
+        << tr("Repetitions")
+        << tr("Avg weight")
+        << tr("Min weight")
+        << tr("Max weight")
+        << tr("Weight delta")
+        << tr("Sauna rounds")
+        << tr("Meditations")
+        << tr("Avg weekly km")
+        << tr("Avg monthly km")
+    );
+}
+
+void StatisticsView::refresh(const Statistics& statistics, const DatasetColumns& columns)
+{
+    const Statistics::Aggregates& years = statistics.getAggregates(Statistics::YEAR);
+
+    // years and the total
+    setRowCount(static_cast<int>(years.size())+1);
+    auto km = [](double meters) { return QString::number(meters/1000.0, 'f', 1); };
+    auto setRowValues = [this](int row, const QString* values, size_t count) {
+        for(int column=0; column<static_cast<int>(count); column++) {
+            QTableWidgetItem* cell = item(row, column);
+            if(!cell) {
+                setItem(row, column, cell = new QTableWidgetItem{});
+            }
+            cell->setText(values[column]);
+        }
+    };
+
+    int row = 0;
+    for(const auto& keyAndYear:years) {
+        const Statistics::Aggregate& y = keyAndYear.second;
+        auto weight = [&y](float weight) { return y.getWeighings() ? QString::number(weight, 'f', 1) : QString{}; };
+
+        const QString values[] = {
+            QString::number(y.year),
+            QString::number(y.instances),
+            km(y.universalMeters),
+            QString::number(y.universalSeconds/3600) + "h",
+            km(y.cyclingMeters),
+            km(y.c2Meters),
+            km(y.runningMeters),
+            QString::number(y.repetitions),
+            weight(y.getAvgWeight()),
+            weight(y.minWeight),
+            weight(y.maxWeight),
+            weight(y.getWeightDelta()),
+            QString::number(y.saunaRounds),
+            QString::number(y.meditations),
+            km(statistics.getAvgMeters(y, Statistics::WEEK)),
+            km(statistics.getAvgMeters(y, Statistics::MONTH))
+        };
+        setRowValues(row, values, sizeof(values)/sizeof(values[0]));
+        row++;
+    }
+
+    // summarized from the columns: rows w/o valid date are included
+    const Statistics::Totals t = statistics.getTotals(columns);
+    auto weight = [&t](double weight) { return t.weighings ? QString::number(weight, 'f', 1) : QString{}; };
+    const QString totals[] = {
+        tr("Total"),
+        QString::number(t.instances),
+        km(t.universalMeters),
+        QString::number(t.universalSeconds/3600) + "h",
+        km(t.cyclingMeters),
+        km(t.c2Meters),
+        km(t.runningMeters),
+        QString::number(t.repetitions),
+        weight(t.avgWeight),
+        weight(t.minWeight),
+        weight(t.maxWeight),
+        QString{},
+        QString::number(t.saunaRounds),
+        QString::number(t.meditations),
+        QString{},
+        QString{}
+    };
+    setRowValues(row, totals, sizeof(totals)/sizeof(totals[0]));
+}
+
+} // etl76 namespace
@@ -0,0 +1,52 @@
+/*
+ statistics_view.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_STATISTICS_VIEW_H
+#define ETL76_STATISTICS_VIEW_H
+
+#include <QtWidgets>
+
+#include "statistics.h"
+
+namespace etl76 {
+
+/**
+ * @brief Statistics panel.
+ *
+ * Yearly statistics - refreshed from (incrementally maintained) statistics
+ * after every edit, there are just a few dozens of rows. The last row is
+ * the total summarized from the columns by column kernels.
+ */
+class StatisticsView : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StatisticsView(QWidget* parent);
+    StatisticsView(const StatisticsView&) = delete;
+    StatisticsView(const StatisticsView&&) = delete;
+    StatisticsView &operator=(const StatisticsView&) = delete;
+    StatisticsView &operator=(const StatisticsView&&) = delete;
+    virtual ~StatisticsView() override {}
+
+    void refresh(const Statistics& statistics, const DatasetColumns& columns);
+};
+
+} // namespace etl76
+
+#endif // ETL76_STATISTICS_VIEW_H
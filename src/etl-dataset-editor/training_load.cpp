@@ -0,0 +1,251 @@
+/*
+ training_load.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "training_load.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "calendar.h"
+
+namespace etl76 {
+
+using namespace std;
+
+static const int64_t NO_DAY = INT64_MIN;
+
+TrainingLoad::TrainingLoad()
+    : loads(),
+      days(),
+      firstDay(NO_DAY),
+      dirtyFrom(0),
+      intensityFactors()
+{
+}
+
+unsigned TrainingLoad::getIntensityFactor(const string& intensity)
+{
+    static const pair<const char*, unsigned> FACTORS[] = {
+        {"recovery", 1},
+        {"easy", 2},
+        {"long", 3},
+        {"fartlek", 4},
+        {"tempo", 5},
+        {"threshold", 6},
+        {"interval", 7},
+        {"intervals", 7},
+        {"rank", 8},
+        {"race", 8}
+    };
+    for(const auto& f:FACTORS) {
+        if(intensity == f.first) {
+            return f.second;
+        }
+    }
+    // unknown intensity is moderate
+    return 3;
+}
+
+void TrainingLoad::classifyIntensities(const DatasetColumns& columns)
+{
+    const CategoricalFeature& intensities = columns.getFeature(DatasetColumns::INTENSITY);
+    for(unsigned code=intensityFactors.size(); code<intensities.size(); code++) {
+        string intensity{intensities.getUtf8Value(code)};
+        for(char& c:intensity) {
+            if(c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        intensityFactors.push_back(static_cast<unsigned char>(getIntensityFactor(intensity)));
+    }
+}
+
+static uint64_t rowLoad(const DatasetColumns& c, size_t row, const vector<unsigned char>& intensityFactors)
+{
+    uint64_t seconds = c.get(DatasetColumns::TOTAL_TIME_SECONDS, row);
+    if(!seconds) {
+        seconds = c.get(DatasetColumns::TIME_SECONDS, row);
+    }
+    if(!seconds) {
+        seconds = static_cast<uint64_t>(c.get(DatasetColumns::DISTANCE_METERS, row)/TrainingLoad::DEFAULT_METERS_PER_SECOND);
+    }
+    const unsigned code = c.getColumn(DatasetColumns::INTENSITY)[row];
+    return seconds * (code < intensityFactors.size() ? intensityFactors[code] : 3);
+}
+
+static bool rowDay(const DatasetColumns& c, size_t row, int64_t& day)
+{
+    const unsigned year = c.get(DatasetColumns::YEAR, row);
+    const unsigned month = c.get(DatasetColumns::MONTH, row);
+    const unsigned dayOfMonth = c.get(DatasetColumns::DAY, row);
+    if(!Calendar::isValidDate(year, month, dayOfMonth)) {
+        return false;
+    }
+    day = Calendar::daysFromCivil(year, month, dayOfMonth);
+    return true;
+}
+
+void TrainingLoad::calculate(const DatasetColumns& c)
+{
+    loads.clear();
+    days.clear();
+    firstDay = NO_DAY;
+    intensityFactors.clear();
+    classifyIntensities(c);
+
+    // range of the series
+    int64_t first = INT64_MAX;
+    int64_t last = INT64_MIN;
+    int64_t day;
+    for(size_t row=0; row<c.size(); row++) {
+        if(rowDay(c, row, day)) {
+            first = min(first, day);
+            last = max(last, day);
+        }
+    }
+    if(first > last) {
+        return;
+    }
+
+    firstDay = first;
+    loads.assign(static_cast<size_t>(last-first+1), 0);
+    for(size_t row=0; row<c.size(); row++) {
+        if(rowDay(c, row, day)) {
+            loads[day-firstDay] += rowLoad(c, row, intensityFactors);
+        }
+    }
+    computeFrom(0);
+}
+
+void TrainingLoad::updateRow(const DatasetColumns& c, size_t row, bool insert)
+{
+    int64_t day;
+    if(!rowDay(c, row, day)) {
+        return;
+    }
+    classifyIntensities(c);
+
+    // series is extended to the day of the new row
+    if(firstDay == NO_DAY) {
+        firstDay = day;
+        dirtyFrom = 0;
+    }
+    if(day < firstDay) {
+        loads.insert(loads.begin(), static_cast<size_t>(firstDay-day), 0);
+        firstDay = day;
+        dirtyFrom = 0;
+    }
+    const size_t index = static_cast<size_t>(day-firstDay);
+    if(index >= loads.size()) {
+        dirtyFrom = min(dirtyFrom, loads.size());
+        loads.resize(index+1, 0);
+    }
+
+    const uint64_t load = rowLoad(c, row, intensityFactors);
+    if(insert) {
+        loads[index] += load;
+    } else {
+        loads[index] -= min(load, loads[index]);
+    }
+    dirtyFrom = min(dirtyFrom, index);
+}
+
+void TrainingLoad::onRowInserted(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, true);
+}
+
+void TrainingLoad::onRowRemoved(const DatasetColumns& columns, size_t row)
+{
+    updateRow(columns, row, false);
+}
+
+const vector<TrainingLoad::Day>& TrainingLoad::getDays()
+{
+    if(dirtyFrom < loads.size()) {
+        computeFrom(dirtyFrom);
+    }
+    return days;
+}
+
+/*
+ * Window sums of the first recomputed day are summed from loads, then
+ * they slide: every day adds the new day and subtracts the one leaving
+ * the window (integer loads - no drift).
+ */
+void TrainingLoad::computeFrom(size_t from)
+{
+    days.resize(loads.size());
+    dirtyFrom = loads.size();
+    if(from >= loads.size()) {
+        return;
+    }
+
+    auto windowSum = [this](size_t to, unsigned windowDays, uint64_t& sum, uint64_t& squares) {
+        sum = squares = 0;
+        for(size_t d = to+1 > windowDays ? to+1-windowDays : 0; d <= to; d++) {
+            sum += loads[d];
+            squares += loads[d]*loads[d];
+        }
+    };
+    uint64_t acuteSum, acuteSquares, chronicSum, chronicSquares;
+    windowSum(from, ACUTE_DAYS, acuteSum, acuteSquares);
+    windowSum(from, CHRONIC_DAYS, chronicSum, chronicSquares);
+
+    static const double MINUTE = 60.0;
+    static_assert(ACUTE_DAYS == MONOTONY_DAYS, "monotony is computed from the acute window");
+    double fitness = from ? days[from-1].fitness : 0;
+    double fatigue = from ? days[from-1].fatigue : 0;
+    for(size_t d=from; d<loads.size(); d++) {
+        if(d > from) {
+            acuteSum += loads[d];
+            acuteSquares += loads[d]*loads[d];
+            chronicSum += loads[d];
+            if(d >= ACUTE_DAYS) {
+                acuteSum -= loads[d-ACUTE_DAYS];
+                acuteSquares -= loads[d-ACUTE_DAYS]*loads[d-ACUTE_DAYS];
+            }
+            if(d >= CHRONIC_DAYS) {
+                chronicSum -= loads[d-CHRONIC_DAYS];
+            }
+        }
+
+        Day& day = days[d];
+        day.day = firstDay + static_cast<int64_t>(d);
+        day.load = loads[d]/MINUTE;
+        // windows before the first day are days w/o training
+        day.acute = acuteSum/MINUTE/ACUTE_DAYS;
+        day.chronic = chronicSum/MINUTE/CHRONIC_DAYS;
+        day.acwr = day.chronic > 0 ? day.acute/day.chronic : 0;
+
+        const double mean = static_cast<double>(acuteSum)/ACUTE_DAYS;
+        const double variance = max(0.0, static_cast<double>(acuteSquares)/ACUTE_DAYS - mean*mean);
+        const double deviation = sqrt(variance);
+        // monotony of a week of identical loads is not defined
+        day.monotony = deviation > 0 ? mean/deviation : 0;
+        day.strain = acuteSum/MINUTE * day.monotony;
+
+        day.form = fitness - fatigue;
+        fitness += (day.load - fitness)/FITNESS_DAYS;
+        fatigue += (day.load - fatigue)/FATIGUE_DAYS;
+        day.fitness = fitness;
+        day.fatigue = fatigue;
+    }
+}
+
+} // namespace etl76
@@ -0,0 +1,124 @@
+/*
+ training_load.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_TRAINING_LOAD_H
+#define ETL76_TRAINING_LOAD_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dataset_columns.h"
+#include "dataset_observer.h"
+
+namespace etl76 {
+
+/**
+ * @brief Training load model.
+ *
+ * Daily training load is derived from the duration (total time, time or
+ * distance at a default pace) and intensity of instances: it is minutes
+ * weighted by intensity factor (session RPE like). Daily series - from
+ * the first to the last day of the dataset - is used to compute:
+ *
+ * - acute (7 days) : chronic (28 days) workload ratio (ACWR),
+ * - Foster's monotony (7 days mean / standard deviation) and strain
+ *   (7 days load * monotony),
+ * - Banister's fitness (CTL, 42 days exponential filter), fatigue (ATL,
+ *   7 days exponential filter) and form (TSB, yesterday's CTL - ATL).
+ *
+ * Windows are sliding sums and filters are recurrences - the series is
+ * computed in O(days). As dataset observer the model updates the load of
+ * the edited day only and recomputes the series from that day on.
+ */
+class TrainingLoad : public DatasetObserver
+{
+    // analytics are saved to/loaded from cache as they are
+    friend class AnalyticsCache;
+
+public:
+    static const unsigned ACUTE_DAYS = 7;
+    static const unsigned CHRONIC_DAYS = 28;
+    static const unsigned MONOTONY_DAYS = 7;
+    static const unsigned FITNESS_DAYS = 42;
+    static const unsigned FATIGUE_DAYS = 7;
+
+    // duration of instances w/ distance only (12km/h)
+    static constexpr double DEFAULT_METERS_PER_SECOND = 12000.0/3600.0;
+
+    /**
+     * @brief Training load model of a day.
+     */
+    struct Day {
+        // day number - see Calendar
+        int64_t day;
+        double load;
+        // average daily load of the acute/chronic window
+        double acute;
+        double chronic;
+        double acwr;
+        double monotony;
+        double strain;
+        double fitness;
+        double fatigue;
+        double form;
+    };
+
+    /**
+     * @brief Intensity factor of (lowercase) intensity.
+     */
+    static unsigned getIntensityFactor(const std::string& intensity);
+
+private:
+    // load in seconds weighted by intensity factor - sums are exact
+    std::vector<uint64_t> loads;
+    std::vector<Day> days;
+    int64_t firstDay;
+    // days from this index on must be recomputed
+    size_t dirtyFrom;
+    // intensity factor by intensity dictionary code
+    std::vector<unsigned char> intensityFactors;
+
+    void classifyIntensities(const DatasetColumns& columns);
+    void updateRow(const DatasetColumns& columns, size_t row, bool insert);
+    void computeFrom(size_t from);
+
+public:
+    TrainingLoad();
+    TrainingLoad(const TrainingLoad&) = delete;
+    TrainingLoad(const TrainingLoad&&) = delete;
+    TrainingLoad &operator=(const TrainingLoad&) = delete;
+    TrainingLoad &operator=(const TrainingLoad&&) = delete;
+
+    /**
+     * @brief Calculate the model of all rows.
+     */
+    void calculate(const DatasetColumns& columns);
+
+    void onRowInserted(const DatasetColumns& columns, size_t row) override;
+    void onRowRemoved(const DatasetColumns& columns, size_t row) override;
+
+    /**
+     * @brief Days from the first to the last day of the dataset - edited suffix is recomputed first.
+     */
+    const std::vector<Day>& getDays();
+};
+
+} // namespace etl76
+
+#endif // ETL76_TRAINING_LOAD_H
@@ -0,0 +1,187 @@
+/*
+ utf8_column.cpp     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "utf8_column.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace etl76 {
+
+using namespace std;
+
+Utf8Column::Utf8Column()
+    : bytes(),
+      spans(),
+      values(),
+      liveBytes(0)
+{
+}
+
+Utf8Column::Span Utf8Column::store(const char* value, size_t size)
+{
+    Span span{bytes.size(), size};
+    bytes.insert(bytes.end(), value, value+size);
+    liveBytes += size;
+    return span;
+}
+
+/*
+ * Live spans of the source are copied in row order - dead bytes are dropped.
+ */
+void Utf8Column::copyLive(const Utf8Column& src)
+{
+    vector<char> live{};
+    live.reserve(src.liveBytes);
+    vector<Span> liveSpans{};
+    liveSpans.reserve(src.spans.size());
+    for(const Span& span:src.spans) {
+        liveSpans.push_back(Span{live.size(), span.size});
+        live.insert(live.end(), src.bytes.begin()+span.offset, src.bytes.begin()+span.offset+span.size);
+    }
+    liveBytes = live.size();
+    bytes.swap(live);
+    spans.swap(liveSpans);
+}
+
+void Utf8Column::compactIfSparse()
+{
+    const size_t deadBytes = bytes.size()-min(liveBytes, bytes.size());
+    if(bytes.size() >= MIN_COMPACTION_SIZE && deadBytes > liveBytes/2) {
+        // decoded values stay: rows are not changed
+        copyLive(*this);
+    }
+}
+
+size_t Utf8Column::getByteSize() const
+{
+    size_t byteSize = bytes.capacity() + spans.capacity()*sizeof(Span) + values.capacity()*sizeof(QString);
+    for(const QString& value:values) {
+        byteSize += value.size()*sizeof(QChar);
+    }
+    return byteSize;
+}
+
+const QString& Utf8Column::get(size_t row) const
+{
+    static const QString EMPTY{};
+
+    const Span& span = spans[row];
+    if(!span.size) {
+        return EMPTY;
+    }
+    QString& value = values[row];
+    if(value.isNull()) {
+        value = QString::fromUtf8(bytes.data()+span.offset, static_cast<int>(span.size));
+    }
+    return value;
+}
+
+void Utf8Column::reserve(size_t capacity)
+{
+    spans.reserve(capacity);
+    values.reserve(capacity);
+}
+
+void Utf8Column::clear()
+{
+    bytes.clear();
+    spans.clear();
+    values.clear();
+    liveBytes = 0;
+}
+
+void Utf8Column::assign(const Utf8Column& src)
+{
+    copyLive(src);
+    // copy is written by the saver: values are not needed there
+    values.assign(src.values.size(), QString{});
+}
+
+void Utf8Column::append(const char* value, size_t size)
+{
+    spans.push_back(store(value, size));
+    values.emplace_back();
+}
+
+void Utf8Column::append(const QString& value)
+{
+    QByteArray utf8 = value.toUtf8();
+    spans.push_back(store(utf8.constData(), static_cast<size_t>(utf8.size())));
+    values.push_back(value);
+}
+
+void Utf8Column::splice(Utf8Column& src)
+{
+    const uint64_t base = bytes.size();
+    bytes.insert(bytes.end(), src.bytes.begin(), src.bytes.end());
+    liveBytes += src.liveBytes;
+    spans.reserve(spans.size()+src.spans.size());
+    for(const Span& span:src.spans) {
+        spans.push_back(Span{base+span.offset, span.size});
+    }
+    values.insert(values.end(), make_move_iterator(src.values.begin()), make_move_iterator(src.values.end()));
+    src.clear();
+}
+
+void Utf8Column::insert(size_t row, const Utf8Column& src, size_t srcRow)
+{
+    // copies: src may be this column
+    Span span = src.spans[srcRow];
+    if(&src != this) {
+        const string_view value = src.getUtf8(srcRow);
+        span = store(value.data(), value.size());
+    } else {
+        // span is shared by both rows
+        liveBytes += span.size;
+    }
+    const QString decoded = src.values[srcRow];
+    spans.insert(spans.begin()+row, span);
+    values.insert(values.begin()+row, decoded);
+}
+
+void Utf8Column::set(size_t row, const Utf8Column& src, size_t srcRow)
+{
+    liveBytes -= spans[row].size;
+    if(&src == this) {
+        spans[row] = spans[srcRow];
+        values[row] = values[srcRow];
+        liveBytes += spans[row].size;
+    } else {
+        const string_view value = src.getUtf8(srcRow);
+        spans[row] = store(value.data(), value.size());
+        values[row] = src.values[srcRow];
+    }
+    compactIfSparse();
+}
+
+void Utf8Column::erase(size_t row)
+{
+    liveBytes -= spans[row].size;
+    spans.erase(spans.begin()+row);
+    values.erase(values.begin()+row);
+    compactIfSparse();
+}
+
+void Utf8Column::swap(size_t a, size_t b)
+{
+    std::swap(spans[a], spans[b]);
+    std::swap(values[a], values[b]);
+}
+
+} // namespace etl76
@@ -0,0 +1,105 @@
+/*
+ utf8_column.h     Endurance Training Log dataset editor
+
+ Copyright (C) 2020 Martin Dvorak <martin.dvorak@mindforger.com>
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ETL76_UTF8_COLUMN_H
+#define ETL76_UTF8_COLUMN_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QString>
+
+namespace etl76 {
+
+/**
+ * @brief Column of strings kept as UTF-8 in one arena.
+ *
+ * Parser copies field bytes to the arena as they are - there is no
+ * conversion and no allocation per value. QString (UTF-16) of a value
+ * is decoded when it is asked for (table, dialog) and kept for later
+ * calls, values of rows which are never shown are never decoded.
+ * Writer, snapshot, hash and filter use UTF-8 bytes directly.
+ *
+ * Bytes of erased or overwritten values stay in the arena until they
+ * exceed half of live bytes - the arena is compacted then (amortized
+ * by edits which made them dead). Copy made by assign() is compact.
+ *
+ * UTF-8 may be read by any thread, get() decodes to the column and it
+ * must be called by one (UI) thread only.
+ */
+class Utf8Column
+{
+private:
+    struct Span
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // arena is not compacted below this size
+    static const size_t MIN_COMPACTION_SIZE = 1<<16;
+
+    std::vector<char> bytes;
+    std::vector<Span> spans;
+    // null until decoded (empty values are never decoded)
+    mutable std::vector<QString> values;
+    // sum of span sizes - the rest of the arena is dead
+    size_t liveBytes;
+
+    Span store(const char* value, size_t size);
+    void copyLive(const Utf8Column& src);
+    void compactIfSparse();
+
+public:
+    Utf8Column();
+    Utf8Column(const Utf8Column&) = delete;
+    Utf8Column(const Utf8Column&&) = delete;
+    Utf8Column &operator=(const Utf8Column&) = delete;
+    Utf8Column &operator=(const Utf8Column&&) = delete;
+
+    size_t size() const { return spans.size(); }
+    size_t getByteSize() const;
+
+    std::string_view getUtf8(size_t row) const {
+        return std::string_view{bytes.data()+spans[row].offset, static_cast<size_t>(spans[row].size)};
+    }
+    const QString& get(size_t row) const;
+
+    void reserve(size_t capacity);
+    void clear();
+    void assign(const Utf8Column& src);
+
+    void append(const char* value, size_t size);
+    void append(const char* value) { append(value, std::char_traits<char>::length(value)); }
+    // value is kept as decoded
+    void append(const QString& value);
+    /**
+     * @brief Move all values of other column (batch) to the end - batch is left empty.
+     */
+    void splice(Utf8Column& src);
+    void insert(size_t row, const Utf8Column& src, size_t srcRow);
+    void set(size_t row, const Utf8Column& src, size_t srcRow);
+    void erase(size_t row);
+    void swap(size_t a, size_t b);
+};
+
+} // namespace etl76
+
+#endif // ETL76_UTF8_COLUMN_H